@@ -0,0 +1,73 @@
+#include "benchmark.h"
+#include "../core/json.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+namespace glue
+{
+	namespace bench
+	{
+		namespace
+		{
+			volatile float gFloatSink;
+			volatile bool gBoolSink;
+			volatile int gIntSink;
+		}
+
+		void consume(float value)
+		{
+			gFloatSink = value;
+		}
+
+		void consume(bool value)
+		{
+			gBoolSink = value;
+		}
+
+		void consume(int value)
+		{
+			gIntSink = value;
+		}
+
+		Benchmark::Benchmark(const std::string& filter, double min_repetition_time, int numof_repetitions)
+			: m_filter(filter)
+			, m_min_repetition_time(min_repetition_time)
+			, m_numof_repetitions(numof_repetitions > 0 ? numof_repetitions : 1)
+		{}
+
+		void Benchmark::writeJson(const std::string& path) const
+		{
+			std::ofstream file(path);
+			if (!file)
+			{
+				throw std::runtime_error("Error: Cannot open the benchmark file " + path);
+			}
+
+			file << "{\n  \"results\": [";
+			bool first = true;
+			for (const auto& result : m_results)
+			{
+				file << (first ? "\n" : ",\n") << "    {\"name\": \"" << core::json::escape(result.name) << "\", \"ns_per_op\": " << result.ns_per_op <<
+					", \"ops_per_second\": " << result.ops_per_second << ", \"rays\": " << (result.rays ? "true" : "false") << "}";
+				first = false;
+			}
+			file << "\n  ]\n}\n";
+		}
+
+		void Benchmark::report(const Result& result) const
+		{
+			auto flags = std::cout.flags();
+			std::cout << std::left << std::setw(56) << result.name << std::right << std::fixed << std::setprecision(2) <<
+				std::setw(12) << result.ns_per_op << " ns/op";
+			if (result.rays)
+			{
+				std::cout << std::setw(12) << result.ops_per_second * 1e-6 << " Mrays/s";
+			}
+			std::cout << std::endl;
+			std::cout.flags(flags);
+		}
+	}
+}
\ No newline at end of file
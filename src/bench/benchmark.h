@@ -0,0 +1,54 @@
+#ifndef __GLUE__BENCH__BENCHMARK__
+#define __GLUE__BENCH__BENCHMARK__
+
+#include <string>
+#include <vector>
+
+namespace glue
+{
+	namespace bench
+	{
+		//Keeps the compiler from optimizing away the results of a kernel.
+		void consume(float value);
+		void consume(bool value);
+		void consume(int value);
+
+		//Runs kernels and reports the median time per operation over a number of repetitions.
+		//A kernel is called as kernel(numof_ops) and has to do that many operations on deterministic inputs.
+		class Benchmark
+		{
+		public:
+			struct Result
+			{
+				std::string name;
+				double ns_per_op;
+				double ops_per_second;
+				bool rays; //Ray kernels are reported in rays per second.
+			};
+
+		public:
+			//Only the kernels whose names contain the filter are run.
+			Benchmark(const std::string& filter, double min_repetition_time, int numof_repetitions);
+
+			template<typename Kernel>
+			void run(const std::string& name, bool rays, const Kernel& kernel);
+
+			void writeJson(const std::string& path) const;
+
+			const std::vector<Result>& get_results() const { return m_results; }
+
+		private:
+			std::string m_filter;
+			double m_min_repetition_time; //In seconds.
+			int m_numof_repetitions;
+			std::vector<Result> m_results;
+
+		private:
+			void report(const Result& result) const;
+		};
+	}
+}
+
+#include "benchmark.inl"
+
+#endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <chrono>
+
+namespace glue
+{
+	namespace bench
+	{
+		template<typename Kernel>
+		void Benchmark::run(const std::string& name, bool rays, const Kernel& kernel)
+		{
+			if (name.find(m_filter) == std::string::npos)
+			{
+				return;
+			}
+
+			auto measure = [&kernel](long long numof_ops)
+			{
+				auto start = std::chrono::steady_clock::now();
+				kernel(numof_ops);
+				return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			};
+
+			//The operation count is doubled until a repetition takes long enough to be timed reliably.
+			//The first calls also warm up the caches.
+			long long numof_ops = 1;
+			while (measure(numof_ops) < m_min_repetition_time && numof_ops < (1LL << 40))
+			{
+				numof_ops *= 2;
+			}
+
+			std::vector<double> times;
+			for (int i = 0; i < m_numof_repetitions; ++i)
+			{
+				times.push_back(measure(numof_ops));
+			}
+			std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+			auto time = times[times.size() / 2];
+
+			m_results.push_back(Result{ name, time * 1e9 / numof_ops, numof_ops / time, rays });
+			report(m_results.back());
+		}
+	}
+}
\ No newline at end of file
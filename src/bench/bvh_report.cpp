@@ -0,0 +1,240 @@
+#include "bvh_report.h"
+#include "../core/json.h"
+#include "../core/real_sampler.h"
+#include "../core/scene.h"
+#include "../core/stats.h"
+#include "../geometry/bvh_quality.h"
+#include "../geometry/mesh.h"
+#include "../geometry/triangle.h"
+#include "../light/diffuse_arealight.h"
+#include "../xml/node.h"
+#include "../xml/parser.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+
+namespace glue
+{
+	namespace bench
+	{
+		namespace
+		{
+			struct BVHResult
+			{
+				std::string name;
+				std::string builder;
+				bool used; //By the renderer.
+				geometry::BVHQuality quality;
+			};
+
+			template<typename Primitive>
+			geometry::BVHQuality analyzeBuilder(geometry::BVH<Primitive>& bvh, bool sah)
+			{
+				if (sah)
+				{
+					bvh.buildWithSAHSplit();
+				}
+				else
+				{
+					bvh.buildWithMedianSplit();
+				}
+
+				return geometry::analyzeBVH(bvh.get_root().get());
+			}
+
+			//Triangles own their mappers, so they are copied without texture coordinates, which do not affect the tree.
+			geometry::BVH<geometry::Triangle> copyModel(const geometry::BVH<geometry::Triangle>& model)
+			{
+				geometry::BVH<geometry::Triangle> bvh;
+				for (const auto& triangle : model.get_objects())
+				{
+					auto vertices = triangle.getVertices();
+					bvh.addObject(geometry::Triangle(vertices[0], vertices[1] - vertices[0], vertices[2] - vertices[0],
+						glm::vec2(0.0f), glm::vec2(0.0f), glm::vec2(0.0f)));
+				}
+
+				return bvh;
+			}
+
+			void addModelPath(const geometry::Object::Xml* object, std::vector<std::string>& model_paths, std::unordered_set<std::string>& visited)
+			{
+				auto mesh = dynamic_cast<const geometry::Mesh::Xml*>(object);
+				if (mesh && visited.insert(mesh->datapath).second)
+				{
+					model_paths.push_back(mesh->datapath);
+				}
+			}
+
+			void printHistogram(const char* title, const std::vector<int>& histogram)
+			{
+				std::cout << "    " << title << ":";
+				for (int i = 0; i < static_cast<int>(histogram.size()); ++i)
+				{
+					if (histogram[i])
+					{
+						std::cout << " " << i << ":" << histogram[i];
+					}
+				}
+				std::cout << std::endl;
+			}
+
+			void printResults(const std::vector<BVHResult>& results)
+			{
+				std::cout << std::fixed << std::setprecision(3);
+				for (int i = 0; i < static_cast<int>(results.size()); ++i)
+				{
+					const auto& result = results[i];
+					const auto& quality = result.quality;
+					if (i == 0 || results[i - 1].name != result.name)
+					{
+						std::cout << result.name << " (" << quality.numof_primitives << " primitives)" << std::endl;
+					}
+					std::cout << "  " << std::left << std::setw(8) << (result.builder + (result.used ? "*" : "")) << std::right <<
+						" nodes " << quality.numof_nodes << ", leaves " << quality.numof_leaves << ", depth " << quality.max_depth <<
+						", stack " << quality.max_stack_size << "/" << geometry::cBVHStackSize << ", leaf size " << quality.average_leaf_size <<
+						" avg " << quality.max_leaf_size << " max, SAH cost " << quality.sah_cost << ", sibling overlap " <<
+						quality.average_sibling_overlap << " avg " << quality.max_sibling_overlap << " max" << std::endl;
+					if (result.used)
+					{
+						printHistogram("leaves per depth", quality.depth_histogram);
+						printHistogram("leaves per size", quality.leaf_size_histogram);
+					}
+					if (quality.max_stack_size > geometry::cBVHStackSize)
+					{
+						std::cout << "  Warning: The tree is deeper than the traversal stack allows." << std::endl;
+					}
+				}
+				std::cout << std::defaultfloat;
+			}
+
+			void writeHistogram(std::ofstream& file, const std::vector<int>& histogram)
+			{
+				file << "[";
+				for (int i = 0; i < static_cast<int>(histogram.size()); ++i)
+				{
+					file << (i ? ", " : "") << histogram[i];
+				}
+				file << "]";
+			}
+
+			void writeJson(const std::string& path, const std::string& scene_path, const std::vector<BVHResult>& results,
+				int numof_camera_rays, double nodes_per_ray, double primitives_per_ray)
+			{
+				std::ofstream file(path);
+				if (!file)
+				{
+					throw std::runtime_error("Error: Cannot open the BVH report file " + path);
+				}
+
+				file << "{\n";
+				file << "  \"scene\": \"" << core::json::escape(scene_path) << "\",\n";
+				file << "  \"stack_size\": " << geometry::cBVHStackSize << ",\n";
+				file << "  \"camera_rays\": {\"count\": " << numof_camera_rays << ", \"measured\": " << (core::stats::cEnabled ? "true" : "false") <<
+					", \"bvh_nodes_per_ray\": " << nodes_per_ray << ", \"primitives_per_ray\": " << primitives_per_ray << "},\n";
+				file << "  \"bvhs\": [";
+				bool first = true;
+				for (const auto& result : results)
+				{
+					const auto& quality = result.quality;
+					file << (first ? "\n" : ",\n") << "    {\"name\": \"" << core::json::escape(result.name) << "\", \"builder\": \"" << result.builder <<
+						"\", \"used\": " << (result.used ? "true" : "false") << ", \"primitives\": " << quality.numof_primitives <<
+						", \"nodes\": " << quality.numof_nodes << ", \"leaves\": " << quality.numof_leaves << ", \"max_depth\": " << quality.max_depth <<
+						", \"max_stack_size\": " << quality.max_stack_size << ", \"average_leaf_size\": " << quality.average_leaf_size <<
+						", \"max_leaf_size\": " << quality.max_leaf_size << ", \"sah_cost\": " << quality.sah_cost <<
+						", \"average_sibling_overlap\": " << quality.average_sibling_overlap << ", \"max_sibling_overlap\": " << quality.max_sibling_overlap <<
+						", \"depth_histogram\": ";
+					writeHistogram(file, quality.depth_histogram);
+					file << ", \"leaf_size_histogram\": ";
+					writeHistogram(file, quality.leaf_size_histogram);
+					file << "}";
+					first = false;
+				}
+				file << "\n  ]\n}\n";
+			}
+		}
+
+		void runBVHReport(const BVHReportOptions& options)
+		{
+			core::Scene::Xml scene_xml(xml::Node::getRoot(options.scene_path));
+			core::Scene scene(scene_xml);
+
+			std::vector<BVHResult> results;
+
+			//Scenes are built with the median split below 1024 objects, as in Scene::createObjects.
+			const auto& scene_bvh = scene.getBVH();
+			auto scene_uses_sah = scene_bvh.get_objects().size() >= 1024;
+			for (auto sah : { false, true })
+			{
+				geometry::BVH<std::shared_ptr<geometry::Object>> bvh;
+				for (const auto& object : scene_bvh.get_objects())
+				{
+					bvh.addObject(object);
+				}
+				results.push_back(BVHResult{ "scene", sah ? "sah" : "median", sah == scene_uses_sah, analyzeBuilder(bvh, sah) });
+			}
+
+			//Models are cached by the parser, so this returns the BVHs the scene built.
+			std::vector<std::string> model_paths;
+			std::unordered_set<std::string> visited;
+			for (const auto& object : scene_xml.objects)
+			{
+				addModelPath(object.get(), model_paths, visited);
+			}
+			for (const auto& light : scene_xml.lights)
+			{
+				if (auto area_light = dynamic_cast<const light::DiffuseArealight::Xml*>(light.get()))
+				{
+					addModelPath(area_light->object.get(), model_paths, visited);
+				}
+			}
+			for (const auto& path : model_paths)
+			{
+				auto model = xml::Parser::loadModel(path);
+				for (auto sah : { false, true })
+				{
+					auto bvh = copyModel(*model);
+					results.push_back(BVHResult{ path, sah ? "sah" : "median", sah, analyzeBuilder(bvh, sah) });
+				}
+			}
+
+			//Rays go through random points of random pixels. Steps are summed over the scene BVH and the BVHs of the meshes.
+			auto& counters = core::stats::getThreadCounters().counters;
+			auto nodes_before = counters[static_cast<int>(core::stats::Counter::BVH_NODES_VISITED)];
+			auto primitives_before = counters[static_cast<int>(core::stats::Counter::PRIMITIVES_TESTED)];
+			const auto& resolution = scene.camera->get_resolution();
+			core::PcgSampler sampler;
+			for (int i = 0; i < options.numof_camera_rays; ++i)
+			{
+				auto x = std::min(static_cast<int>(sampler.sample() * resolution.x), resolution.x - 1);
+				auto y = std::min(static_cast<int>(sampler.sample() * resolution.y), resolution.y - 1);
+				geometry::Intersection intersection;
+				scene.intersect(scene.camera->castRay(x, y, sampler.sample(), sampler.sample()), intersection, std::numeric_limits<float>::max());
+			}
+			auto numof_rays = std::max(options.numof_camera_rays, 1);
+			auto nodes_per_ray = static_cast<double>(counters[static_cast<int>(core::stats::Counter::BVH_NODES_VISITED)] - nodes_before) / numof_rays;
+			auto primitives_per_ray = static_cast<double>(counters[static_cast<int>(core::stats::Counter::PRIMITIVES_TESTED)] - primitives_before) / numof_rays;
+
+			printResults(results);
+			if (core::stats::cEnabled)
+			{
+				std::cout << "Camera rays: " << nodes_per_ray << " BVH nodes and " << primitives_per_ray << " primitives per ray over " <<
+					options.numof_camera_rays << " rays" << std::endl;
+			}
+			else
+			{
+				std::cout << "Camera rays: Traversal steps are not counted without GLUE_STATS" << std::endl;
+			}
+
+			if (!options.json_path.empty())
+			{
+				writeJson(options.json_path, options.scene_path, results, options.numof_camera_rays, nodes_per_ray, primitives_per_ray);
+			}
+		}
+	}
+}
\ No newline at end of file
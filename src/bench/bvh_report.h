@@ -0,0 +1,24 @@
+#ifndef __GLUE__BENCH__BVHREPORT__
+#define __GLUE__BENCH__BVHREPORT__
+
+#include <string>
+
+namespace glue
+{
+	namespace bench
+	{
+		struct BVHReportOptions
+		{
+			std::string scene_path;
+			std::string json_path;
+			int numof_camera_rays;
+		};
+
+		//Loads the scene and reports the quality of its BVH and of the BVH of every model it uses, each rebuilt with
+		//every builder so that they can be compared on the same primitives. Traversal steps of camera rays are measured
+		//on the BVHs the renderer built, so they are only reported if the renderer is built with GLUE_STATS.
+		void runBVHReport(const BVHReportOptions& options);
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "convergence.h"
+#include "../core/image.h"
+#include "../core/math.h"
+#include "../core/scene.h"
+#include "../xml/node.h"
+
+#include <glm/glm.hpp>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace glue
+{
+	namespace bench
+	{
+		namespace
+		{
+			struct ConvergencePoint
+			{
+				double time;
+				ImageError error;
+			};
+
+			//Mean SSIM over 8x8 windows that overlap by half, with the usual constants for a dynamic range of 1.
+			double computeSsim(const core::Image& image, const core::Image& reference)
+			{
+				constexpr int cWindowSize = 8;
+				constexpr int cStride = 4;
+				constexpr double cC1 = 0.01 * 0.01;
+				constexpr double cC2 = 0.03 * 0.03;
+
+				auto width = image.get_width();
+				auto height = image.get_height();
+				std::vector<double> x(width * height);
+				std::vector<double> y(width * height);
+				std::vector<glm::vec3> row(width);
+				std::vector<glm::vec3> reference_row(width);
+				for (int j = 0; j < height; ++j)
+				{
+					image.getRow(j, row);
+					reference.getRow(j, reference_row);
+					for (int i = 0; i < width; ++i)
+					{
+						x[j * width + i] = glm::clamp(core::math::rgbToLuminance(row[i]), 0.0f, 1.0f);
+						y[j * width + i] = glm::clamp(core::math::rgbToLuminance(reference_row[i]), 0.0f, 1.0f);
+					}
+				}
+
+				double ssim_sum = 0.0;
+				int numof_windows = 0;
+				for (int wy = 0; wy + cWindowSize <= height; wy += cStride)
+				{
+					for (int wx = 0; wx + cWindowSize <= width; wx += cStride)
+					{
+						double mean_x = 0.0, mean_y = 0.0;
+						for (int j = wy; j < wy + cWindowSize; ++j)
+						{
+							for (int i = wx; i < wx + cWindowSize; ++i)
+							{
+								mean_x += x[j * width + i];
+								mean_y += y[j * width + i];
+							}
+						}
+						constexpr double inv_count = 1.0 / (cWindowSize * cWindowSize);
+						mean_x *= inv_count;
+						mean_y *= inv_count;
+
+						double var_x = 0.0, var_y = 0.0, covar = 0.0;
+						for (int j = wy; j < wy + cWindowSize; ++j)
+						{
+							for (int i = wx; i < wx + cWindowSize; ++i)
+							{
+								auto dx = x[j * width + i] - mean_x;
+								auto dy = y[j * width + i] - mean_y;
+								var_x += dx * dx;
+								var_y += dy * dy;
+								covar += dx * dy;
+							}
+						}
+						var_x *= inv_count;
+						var_y *= inv_count;
+						covar *= inv_count;
+
+						ssim_sum += ((2.0 * mean_x * mean_y + cC1) * (2.0 * covar + cC2)) /
+							((mean_x * mean_x + mean_y * mean_y + cC1) * (var_x + var_y + cC2));
+						++numof_windows;
+					}
+				}
+
+				return numof_windows > 0 ? ssim_sum / numof_windows : 1.0;
+			}
+
+			void writeCsv(const std::string& path, const std::vector<ConvergencePoint>& points)
+			{
+				std::ofstream file(path);
+				if (!file)
+				{
+					throw std::runtime_error("Error: Cannot open the convergence file " + path);
+				}
+
+				file << "time,rmse,relmse,ssim,relmse_x_time\n";
+				for (const auto& point : points)
+				{
+					file << point.time << "," << point.error.rmse << "," << point.error.rel_mse << "," << point.error.ssim << "," <<
+						point.error.rel_mse * point.time << "\n";
+				}
+			}
+
+			void writeJson(const std::string& path, const std::vector<ConvergencePoint>& points)
+			{
+				std::ofstream file(path);
+				if (!file)
+				{
+					throw std::runtime_error("Error: Cannot open the convergence file " + path);
+				}
+
+				file << "{\n  \"points\": [";
+				bool first = true;
+				for (const auto& point : points)
+				{
+					file << (first ? "\n" : ",\n") << "    {\"time\": " << point.time << ", \"rmse\": " << point.error.rmse <<
+						", \"relmse\": " << point.error.rel_mse << ", \"ssim\": " << point.error.ssim <<
+						", \"relmse_x_time\": " << point.error.rel_mse * point.time << "}";
+					first = false;
+				}
+				file << "\n  ]\n}\n";
+			}
+		}
+
+		ImageError computeImageError(const core::Image& image, const core::Image& reference)
+		{
+			if (image.get_width() != reference.get_width() || image.get_height() != reference.get_height())
+			{
+				throw std::runtime_error("Error: Image and reference sizes do not match");
+			}
+
+			//Keeps the relative error of black pixels finite.
+			constexpr double cEpsilon = 1e-2;
+
+			double squared_error_sum = 0.0;
+			double relative_error_sum = 0.0;
+			std::vector<glm::vec3> row(image.get_width());
+			std::vector<glm::vec3> reference_row(image.get_width());
+			for (int j = 0; j < image.get_height(); ++j)
+			{
+				image.getRow(j, row);
+				reference.getRow(j, reference_row);
+				for (int i = 0; i < image.get_width(); ++i)
+				{
+					auto value = glm::dvec3(row[i]);
+					auto reference_value = glm::dvec3(reference_row[i]);
+					auto squared_error = (value - reference_value) * (value - reference_value);
+					squared_error_sum += squared_error.x + squared_error.y + squared_error.z;
+					auto relative_error = squared_error / (reference_value * reference_value + cEpsilon);
+					relative_error_sum += relative_error.x + relative_error.y + relative_error.z;
+				}
+			}
+			auto numof_values = 3.0 * image.get_width() * image.get_height();
+
+			return ImageError{ glm::sqrt(squared_error_sum / numof_values), relative_error_sum / numof_values, computeSsim(image, reference) };
+		}
+
+		void runConvergence(const ConvergenceOptions& options)
+		{
+			core::Scene::Xml scene_xml(xml::Node::getRoot(options.scene_path));
+			if (options.thread_count > 0)
+			{
+				scene_xml.thread_count = options.thread_count;
+			}
+			scene_xml.time_limit = static_cast<float>(options.duration);
+			scene_xml.output_interval = options.save_reference ? 0.0f : static_cast<float>(options.interval);
+			scene_xml.checkpoint_path.clear();
+			scene_xml.cost_map_path.clear();
+			scene_xml.outputs.clear();
+			core::Scene scene(scene_xml);
+
+			if (options.save_reference)
+			{
+				scene.progress_callback = [&options](const core::Image& image, double time)
+				{
+					image.saveHdr(options.reference_path);
+				};
+				scene.render();
+
+				return;
+			}
+
+			core::Image reference(options.reference_path);
+			std::vector<ConvergencePoint> points;
+			//Intermediate images come from the output thread and the final one from this thread after it is joined, so they never overlap.
+			scene.progress_callback = [&reference, &points](const core::Image& image, double time)
+			{
+				points.push_back(ConvergencePoint{ time, computeImageError(image, reference) });
+				const auto& error = points.back().error;
+				std::cout << std::fixed << std::setprecision(3) << time << " s  RMSE " << std::setprecision(6) << error.rmse << "  relMSE " <<
+					error.rel_mse << "  SSIM " << error.ssim << std::defaultfloat << std::endl;
+			};
+			scene.render();
+
+			//Intermediate images are taken from what the integrator publishes. Once the render is done, the last published image
+			//has to be the final one, otherwise the curve is measured on images that the render never converges to.
+			auto resolution = scene.camera->get_resolution();
+			core::Image published(resolution.x, resolution.y);
+			scene.getProgress(published);
+			auto published_error = computeImageError(published, reference);
+			const auto& final_error = points.back().error;
+			constexpr double cTolerance = 1e-4;
+			if (glm::abs(published_error.rmse - final_error.rmse) > cTolerance * glm::max(final_error.rmse, 1e-3) ||
+				glm::abs(published_error.ssim - final_error.ssim) > cTolerance)
+			{
+				throw std::runtime_error("Error: Published image of the finished render does not match its final image, so the intermediate errors are not reliable");
+			}
+
+			if (!options.output_path.empty())
+			{
+				auto is_json = options.output_path.size() >= 5 && options.output_path.compare(options.output_path.size() - 5, 5, ".json") == 0;
+				if (is_json)
+				{
+					writeJson(options.output_path, points);
+				}
+				else
+				{
+					writeCsv(options.output_path, points);
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
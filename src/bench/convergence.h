@@ -0,0 +1,40 @@
+#ifndef __GLUE__BENCH__CONVERGENCE__
+#define __GLUE__BENCH__CONVERGENCE__
+
+#include "../core/forward_decl.h"
+
+#include <string>
+
+namespace glue
+{
+	namespace bench
+	{
+		struct ImageError
+		{
+			double rmse;
+			double rel_mse; //Squared error relative to the squared reference value, which keeps dark regions from being ignored.
+			double ssim; //Structural similarity of the luminances, clamped to [0, 1]. It is 1 for identical images.
+		};
+
+		//Errors are computed over the linear values of all channels, except for SSIM.
+		ImageError computeImageError(const core::Image& image, const core::Image& reference);
+
+		struct ConvergenceOptions
+		{
+			std::string scene_path;
+			std::string reference_path;
+			std::string output_path; //Written as JSON if it ends with .json, otherwise as CSV.
+			double interval; //In seconds.
+			double duration; //In seconds. If it is not positive, the integrator renders its sample count.
+			int thread_count; //The thread count of the scene is kept if it is not positive.
+			bool save_reference; //Renders the reference instead of measuring against it.
+		};
+
+		//Renders the scene with its integrator and measures the error of the intermediate images against a reference
+		//rendered with many more samples, so that integrators and samplers can be compared by error at equal time.
+		//It throws if the image published at the end of the render does not have the error of the final image.
+		void runConvergence(const ConvergenceOptions& options);
+	}
+}
+
+#endif
\ No newline at end of file
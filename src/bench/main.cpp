@@ -0,0 +1,625 @@
+#include "benchmark.h"
+#include "bvh_report.h"
+#include "convergence.h"
+#include "scene_benchmark.h"
+#include "scene_generator.h"
+#include "../core/discrete_1d_sampler.h"
+#include "../core/image.h"
+#include "../core/math.h"
+#include "../core/real_sampler.h"
+#include "../core/scene.h"
+#include "../core/thread_pool.h"
+#include "../geometry/bbox.h"
+#include "../geometry/bvh.h"
+#include "../geometry/intersection.h"
+#include "../geometry/ray.h"
+#include "../geometry/triangle.h"
+#include "../material/dielectric.h"
+#include "../material/lambertian.h"
+#include "../material/metal.h"
+#include "../material/oren_nayar.h"
+#include "../material/smooth_layered.h"
+#include "../texture/constant_texture.h"
+#include "../texture/image_texture.h"
+#include "../xml/node.h"
+#include "../xml/parser.h"
+
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using namespace glue;
+
+	//Inputs are drawn from fixed sequences so that every run measures the same work.
+	constexpr int cNumofRays = 4096;
+	constexpr int cNumofTriangles = 1024;
+	constexpr int cNumofSoupTriangles = 100000;
+	constexpr int cNumofDirections = 4096;
+	constexpr int cTextureSize = 2048;
+
+	struct Options
+	{
+		std::string filter;
+		std::string json_path;
+		std::vector<std::string> model_paths;
+		std::vector<std::string> scene_paths;
+		std::string texture_path;
+		double min_repetition_time = 0.1;
+		int numof_repetitions = 5;
+		int thread_count = 1;
+		bench::SceneBenchmarkOptions render{ {}, 0, 1, "", "", 0.05f };
+		bench::ConvergenceOptions convergence{ "", "", "", 1.0, 30.0, 0, false };
+		bench::BVHReportOptions bvh_report{ "", "", 65536 };
+		bench::SceneGeneratorOptions generator{ "", "Pathtracer", 64, 4, 64, 10000, 4, 4, 4, 1024, 512, 16, 1 };
+	};
+
+	void printUsage()
+	{
+		std::cout << "Usage: glue_bench [--filter <text>] [--model <obj>]... [--scene <xml>]... [--texture <image>]" << std::endl;
+		std::cout << "                  [--threads <count>] [--repetitions <count>] [--time <seconds>] [--json <path>]" << std::endl;
+		std::cout << "       glue_bench --render <xml or directory>... [--max-threads <count>] [--repetitions <count>]" << std::endl;
+		std::cout << "                  [--json <path>] [--baseline <json>] [--threshold <fraction>]" << std::endl;
+		std::cout << "       glue_bench --converge <xml> --reference <hdr> [--save-reference] [--interval <seconds>] [--duration <seconds>]" << std::endl;
+		std::cout << "                  [--threads <count>] [--output <csv or json>]" << std::endl;
+		std::cout << "       glue_bench --bvh-report <xml> [--rays <count>] [--json <path>]" << std::endl;
+		std::cout << "       glue_bench --generate <directory> [--integrator <Pathtracer or SPPM>] [--spheres <count>] [--models <count>]" << std::endl;
+		std::cout << "                  [--instances <count>] [--triangles <count>] [--area-lights <count>] [--point-lights <count>]" << std::endl;
+		std::cout << "                  [--textures <count>] [--texture-size <pixels>] [--resolution <pixels>] [--samples <count>] [--seed <number>]" << std::endl;
+	}
+
+	glm::vec3 sampleUnitCube(core::RealSampler& sampler)
+	{
+		return glm::vec3(sampler.sample(), sampler.sample(), sampler.sample());
+	}
+
+	//Triangles of about the given size scattered in the unit cube.
+	std::vector<geometry::Triangle> createTriangles(int count, float size, core::RealSampler& sampler)
+	{
+		std::vector<geometry::Triangle> triangles;
+		for (int i = 0; i < count; ++i)
+		{
+			auto v0 = sampleUnitCube(sampler);
+			auto edge1 = (sampleUnitCube(sampler) - 0.5f) * size;
+			auto edge2 = (sampleUnitCube(sampler) - 0.5f) * size;
+			triangles.emplace_back(v0, edge1, edge2, glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(0.0f, 1.0f));
+		}
+
+		return triangles;
+	}
+
+	//Rays from a sphere around the bounding box towards random points inside it.
+	std::vector<geometry::Ray> createRays(int count, const geometry::BBox& bbox, core::RealSampler& sampler)
+	{
+		auto center = (bbox.get_min() + bbox.get_max()) * 0.5f;
+		auto extent = bbox.get_max() - bbox.get_min();
+		auto radius = glm::length(extent);
+
+		std::vector<geometry::Ray> rays;
+		for (int i = 0; i < count; ++i)
+		{
+			auto origin = center + core::math::sampleSphereUniform(sampler.sample(), sampler.sample()).toCartesianCoordinate() * radius;
+			auto target = bbox.get_min() + sampleUnitCube(sampler) * extent;
+			rays.emplace_back(origin, glm::normalize(target - origin));
+		}
+
+		return rays;
+	}
+
+	std::vector<glm::vec3> createHemisphereDirections(int count, core::RealSampler& sampler)
+	{
+		std::vector<glm::vec3> directions;
+		for (int i = 0; i < count; ++i)
+		{
+			directions.push_back(core::math::sampleHemisphereCosine(sampler.sample(), sampler.sample()).toCartesianCoordinate());
+		}
+
+		return directions;
+	}
+
+	void benchmarkPrimitives(bench::Benchmark& benchmark)
+	{
+		core::PcgSampler sampler(1);
+		auto triangles = createTriangles(cNumofTriangles, 0.2f, sampler);
+		auto rays = createRays(cNumofRays, geometry::BBox(glm::vec3(0.0f), glm::vec3(1.0f)), sampler);
+
+		benchmark.run("Triangle::intersect", true, [&](long long numof_ops)
+		{
+			int hits = 0;
+			for (long long i = 0; i < numof_ops; ++i)
+			{
+				geometry::Intersection intersection;
+				hits += triangles[i % cNumofTriangles].intersect(rays[i % cNumofRays], intersection, std::numeric_limits<float>::max());
+			}
+			bench::consume(hits);
+		});
+
+		benchmark.run("Triangle::intersectShadowRay", true, [&](long long numof_ops)
+		{
+			int hits = 0;
+			for (long long i = 0; i < numof_ops; ++i)
+			{
+				hits += triangles[i % cNumofTriangles].intersectShadowRay(rays[i % cNumofRays], std::numeric_limits<float>::max());
+			}
+			bench::consume(hits);
+		});
+
+		std::vector<geometry::BBox> bboxes;
+		for (const auto& triangle : triangles)
+		{
+			bboxes.push_back(triangle.getBBox());
+		}
+		std::vector<glm::vec3> inv_directions;
+		for (const auto& ray : rays)
+		{
+			inv_directions.push_back(1.0f / ray.get_direction());
+		}
+
+		benchmark.run("BBox::intersect", true, [&](long long numof_ops)
+		{
+			float sum = 0.0f;
+			for (long long i = 0; i < numof_ops; ++i)
+			{
+				sum += bboxes[i % cNumofTriangles].intersect(rays[i % cNumofRays].get_origin(), inv_directions[i % cNumofRays]).x;
+			}
+			bench::consume(sum);
+		});
+	}
+
+	template<typename Primitive>
+	void benchmarkBVHTraversal(bench::Benchmark& benchmark, const std::string& name, const geometry::BVH<Primitive>& bvh,
+		const std::vector<geometry::Ray>& rays)
+	{
+		int numof_rays = rays.size();
+		benchmark.run("BVH::intersect (" + name + ")", true, [&](long long numof_ops)
+		{
+			int hits = 0;
+			for (long long i = 0; i < numof_ops; ++i)
+			{
+				geometry::Intersection intersection;
+				hits += bvh.intersect(rays[i % numof_rays], intersection, std::numeric_limits<float>::max());
+			}
+			bench::consume(hits);
+		});
+
+		benchmark.run("BVH::intersectShadowRay (" + name + ")", true, [&](long long numof_ops)
+		{
+			int hits = 0;
+			for (long long i = 0; i < numof_ops; ++i)
+			{
+				hits += bvh.intersectShadowRay(rays[i % numof_rays], std::numeric_limits<float>::max());
+			}
+			bench::consume(hits);
+		});
+	}
+
+	void benchmarkBVH(bench::Benchmark& benchmark, const Options& options)
+	{
+		core::PcgSampler sampler(2);
+		geometry::BVH<geometry::Triangle> bvh;
+		for (auto& triangle : createTriangles(cNumofSoupTriangles, 0.02f, sampler))
+		{
+			bvh.addObject(std::move(triangle));
+		}
+
+		//Builds reorder the triangles in place, so every build after the first one starts from the order of the previous one.
+		benchmark.run("BVH::buildWithMedianSplit (100k triangle soup)", false, [&](long long numof_ops)
+		{
+			for (long long i = 0; i < numof_ops; ++i)
+			{
+				bvh.buildWithMedianSplit();
+			}
+		});
+
+		benchmark.run("BVH::buildWithSAHSplit (100k triangle soup)", false, [&](long long numof_ops)
+		{
+			for (long long i = 0; i < numof_ops; ++i)
+			{
+				bvh.buildWithSAHSplit();
+			}
+		});
+
+		bvh.buildWithSAHSplit();
+		benchmarkBVHTraversal(benchmark, "100k triangle soup", bvh, createRays(cNumofRays, geometry::BBox(glm::vec3(0.0f), glm::vec3(1.0f)), sampler));
+
+		for (const auto& path : options.model_paths)
+		{
+			auto model = xml::Parser::loadModel(path);
+			geometry::BBox bbox;
+			for (const auto& triangle : model->get_objects())
+			{
+				bbox.extend(triangle.getBBox());
+			}
+			benchmarkBVHTraversal(benchmark, path, *model, createRays(cNumofRays, bbox, sampler));
+		}
+	}
+
+	void benchmarkScenes(bench::Benchmark& benchmark, const Options& options)
+	{
+		for (const auto& path : options.scene_paths)
+		{
+			core::Scene::Xml scene_xml(xml::Node::getRoot(path));
+			scene_xml.thread_count = options.thread_count;
+			core::Scene scene(scene_xml);
+
+			//Camera rays through the centers of the pixels, in scanline order.
+			auto resolution = scene.camera->get_resolution();
+			std::vector<geometry::Ray> rays;
+			for (int y = 0; y < resolution.y; ++y)
+			{
+				for (int x = 0; x < resolution.x; ++x)
+				{
+					rays.push_back(scene.camera->castRay(x, y));
+				}
+			}
+			int numof_rays = rays.size();
+
+			benchmark.run("Scene::intersect (" + path + " camera rays)", true, [&](long long numof_ops)
+			{
+				int hits = 0;
+				for (long long i = 0; i < numof_ops; ++i)
+				{
+					geometry::Intersection intersection;
+					hits += scene.intersect(rays[i % numof_rays], intersection, std::numeric_limits<float>::max());
+				}
+				bench::consume(hits);
+			});
+
+			benchmark.run("Scene::intersectShadowRay (" + path + " camera rays)", true, [&](long long numof_ops)
+			{
+				int hits = 0;
+				for (long long i = 0; i < numof_ops; ++i)
+				{
+					hits += scene.intersectShadowRay(rays[i % numof_rays], std::numeric_limits<float>::max());
+				}
+				bench::consume(hits);
+			});
+		}
+	}
+
+	void benchmarkSamplers(bench::Benchmark& benchmark)
+	{
+		for (int size : { 1024, 1024 * 1024 })
+		{
+			core::PcgSampler sampler(3);
+			std::vector<float> pdf;
+			for (int i = 0; i < size; ++i)
+			{
+				pdf.push_back(sampler.sample());
+			}
+			core::Discrete1DSampler discrete_sampler(pdf);
+
+			benchmark.run("Discrete1DSampler::sample (" + std::to_string(size) + " entries)", false, [&](long long numof_ops)
+			{
+				int sum = 0;
+				for (long long i = 0; i < numof_ops; ++i)
+				{
+					sum += discrete_sampler.sample(sampler);
+				}
+				bench::consume(sum);
+			});
+		}
+	}
+
+	void benchmarkMaterials(bench::Benchmark& benchmark)
+	{
+		auto kd = []() { return std::make_unique<texture::ConstantTexture::Xml>(glm::vec3(0.5f)); };
+		auto roughness = []() { return std::make_unique<texture::ConstantTexture::Xml>(glm::vec3(0.3f)); };
+
+		std::vector<std::pair<std::string, std::unique_ptr<material::BsdfMaterial>>> materials;
+		materials.emplace_back("Lambertian", material::Lambertian::Xml(kd()).create());
+		materials.emplace_back("OrenNayar", material::OrenNayar::Xml(kd(), 0.5f).create());
+		materials.emplace_back("Metal", material::Metal::Xml(glm::vec3(0.2f, 0.92f, 1.1f), glm::vec3(3.9f, 2.45f, 2.14f), roughness()).create());
+		materials.emplace_back("Dielectric", material::Dielectric::Xml(1.5f, roughness()).create());
+		materials.emplace_back("SmoothLayered", material::SmoothLayered::Xml(kd(), 1.5f).create());
+
+		core::PcgSampler sampler(4);
+		auto wos = createHemisphereDirections(cNumofDirections, sampler);
+		auto wis = createHemisphereDirections(cNumofDirections, sampler);
+		geometry::Intersection intersection;
+		intersection.uv = glm::vec2(0.5f);
+
+		for (const auto& material : materials)
+		{
+			const auto& bsdf_material = *material.second;
+			intersection.bsdf_material = &bsdf_material;
+			intersection.bsdf_choice = 0;
+
+			benchmark.run(material.first + "::sampleWi", false, [&](long long numof_ops)
+			{
+				float sum = 0.0f;
+				for (long long i = 0; i < numof_ops; ++i)
+				{
+					sum += bsdf_material.sampleWi(wos[i % cNumofDirections], sampler, intersection).second.x;
+				}
+				bench::consume(sum);
+			});
+
+			benchmark.run(material.first + "::getBsdf", false, [&](long long numof_ops)
+			{
+				float sum = 0.0f;
+				for (long long i = 0; i < numof_ops; ++i)
+				{
+					sum += bsdf_material.getBsdf(wis[i % cNumofDirections], wos[i % cNumofDirections], intersection).x;
+				}
+				bench::consume(sum);
+			});
+
+			benchmark.run(material.first + "::getPdf", false, [&](long long numof_ops)
+			{
+				float sum = 0.0f;
+				for (long long i = 0; i < numof_ops; ++i)
+				{
+					sum += bsdf_material.getPdf(wis[i % cNumofDirections], wos[i % cNumofDirections], intersection);
+				}
+				bench::consume(sum);
+			});
+		}
+	}
+
+	void benchmarkTextures(bench::Benchmark& benchmark, const Options& options)
+	{
+		//Without a given image, a deterministic one is written to the working directory and removed afterwards.
+		auto path = options.texture_path;
+		if (path.empty())
+		{
+			path = "glue_bench_texture.hdr";
+			core::Image image(cTextureSize, cTextureSize);
+			for (int y = 0; y < cTextureSize; ++y)
+			{
+				for (int x = 0; x < cTextureSize; ++x)
+				{
+					image.set(x, y, glm::vec3((x ^ y) & 255, x & 255, y & 255) / 255.0f);
+				}
+			}
+			image.saveHdr(path);
+		}
+		auto texture = texture::ImageTexture::Xml(path).create();
+		if (options.texture_path.empty())
+		{
+			std::remove(path.c_str());
+		}
+
+		core::PcgSampler sampler(5);
+		std::vector<geometry::Intersection> intersections(cNumofDirections);
+		for (auto& intersection : intersections)
+		{
+			intersection.uv = glm::vec2(sampler.sample(), sampler.sample());
+		}
+
+		benchmark.run("ImageTexture::fetch (random uv)", false, [&](long long numof_ops)
+		{
+			float sum = 0.0f;
+			for (long long i = 0; i < numof_ops; ++i)
+			{
+				sum += texture->fetch(intersections[i % cNumofDirections]).x;
+			}
+			bench::consume(sum);
+		});
+
+		//Footprints up to a tenth of the texture cover all of the levels down to the 8x8 one.
+		for (auto& intersection : intersections)
+		{
+			intersection.dpdu = glm::vec3(1.0f, 0.0f, 0.0f);
+			intersection.dpdv = glm::vec3(0.0f, 1.0f, 0.0f);
+			intersection.footprint = 0.1f * sampler.sample();
+		}
+		benchmark.run("ImageTexture::fetch (random uv and footprint)", false, [&](long long numof_ops)
+		{
+			float sum = 0.0f;
+			for (long long i = 0; i < numof_ops; ++i)
+			{
+				sum += texture->fetch(intersections[i % cNumofDirections]).x;
+			}
+			bench::consume(sum);
+		});
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		Options options;
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string argument(argv[i]);
+			if (argument == "--filter" && i + 1 < argc)
+			{
+				options.filter = argv[++i];
+			}
+			else if (argument == "--model" && i + 1 < argc)
+			{
+				options.model_paths.push_back(argv[++i]);
+			}
+			else if (argument == "--scene" && i + 1 < argc)
+			{
+				options.scene_paths.push_back(argv[++i]);
+			}
+			else if (argument == "--texture" && i + 1 < argc)
+			{
+				options.texture_path = argv[++i];
+			}
+			else if (argument == "--render" && i + 1 < argc)
+			{
+				options.render.scene_paths.push_back(argv[++i]);
+			}
+			else if (argument == "--max-threads" && i + 1 < argc)
+			{
+				options.render.max_thread_count = std::stoi(argv[++i]);
+			}
+			else if (argument == "--baseline" && i + 1 < argc)
+			{
+				options.render.baseline_path = argv[++i];
+			}
+			else if (argument == "--threshold" && i + 1 < argc)
+			{
+				options.render.regression_threshold = std::stof(argv[++i]);
+			}
+			else if (argument == "--converge" && i + 1 < argc)
+			{
+				options.convergence.scene_path = argv[++i];
+			}
+			else if (argument == "--reference" && i + 1 < argc)
+			{
+				options.convergence.reference_path = argv[++i];
+			}
+			else if (argument == "--save-reference")
+			{
+				options.convergence.save_reference = true;
+			}
+			else if (argument == "--interval" && i + 1 < argc)
+			{
+				options.convergence.interval = std::stod(argv[++i]);
+			}
+			else if (argument == "--duration" && i + 1 < argc)
+			{
+				options.convergence.duration = std::stod(argv[++i]);
+			}
+			else if (argument == "--output" && i + 1 < argc)
+			{
+				options.convergence.output_path = argv[++i];
+			}
+			else if (argument == "--bvh-report" && i + 1 < argc)
+			{
+				options.bvh_report.scene_path = argv[++i];
+			}
+			else if (argument == "--rays" && i + 1 < argc)
+			{
+				options.bvh_report.numof_camera_rays = std::stoi(argv[++i]);
+			}
+			else if (argument == "--generate" && i + 1 < argc)
+			{
+				options.generator.directory = argv[++i];
+			}
+			else if (argument == "--integrator" && i + 1 < argc)
+			{
+				options.generator.integrator = argv[++i];
+			}
+			else if (argument == "--spheres" && i + 1 < argc)
+			{
+				options.generator.numof_spheres = std::stoi(argv[++i]);
+			}
+			else if (argument == "--models" && i + 1 < argc)
+			{
+				options.generator.numof_models = std::stoi(argv[++i]);
+			}
+			else if (argument == "--instances" && i + 1 < argc)
+			{
+				options.generator.numof_mesh_instances = std::stoi(argv[++i]);
+			}
+			else if (argument == "--triangles" && i + 1 < argc)
+			{
+				options.generator.triangles_per_model = std::stoi(argv[++i]);
+			}
+			else if (argument == "--area-lights" && i + 1 < argc)
+			{
+				options.generator.numof_area_lights = std::stoi(argv[++i]);
+			}
+			else if (argument == "--point-lights" && i + 1 < argc)
+			{
+				options.generator.numof_point_lights = std::stoi(argv[++i]);
+			}
+			else if (argument == "--textures" && i + 1 < argc)
+			{
+				options.generator.numof_textures = std::stoi(argv[++i]);
+			}
+			else if (argument == "--texture-size" && i + 1 < argc)
+			{
+				options.generator.texture_size = std::stoi(argv[++i]);
+			}
+			else if (argument == "--resolution" && i + 1 < argc)
+			{
+				options.generator.resolution = std::stoi(argv[++i]);
+			}
+			else if (argument == "--samples" && i + 1 < argc)
+			{
+				options.generator.sample_count = std::stoi(argv[++i]);
+			}
+			else if (argument == "--seed" && i + 1 < argc)
+			{
+				options.generator.seed = std::stoull(argv[++i]);
+			}
+			else if (argument == "--threads" && i + 1 < argc)
+			{
+				options.thread_count = std::stoi(argv[++i]);
+				options.convergence.thread_count = options.thread_count;
+			}
+			else if (argument == "--repetitions" && i + 1 < argc)
+			{
+				options.numof_repetitions = std::stoi(argv[++i]);
+				options.render.numof_repetitions = options.numof_repetitions;
+			}
+			else if (argument == "--time" && i + 1 < argc)
+			{
+				options.min_repetition_time = std::stod(argv[++i]);
+			}
+			else if (argument == "--json" && i + 1 < argc)
+			{
+				options.json_path = argv[++i];
+			}
+			else
+			{
+				printUsage();
+				return 0;
+			}
+		}
+
+		if (!options.bvh_report.scene_path.empty())
+		{
+			options.bvh_report.json_path = options.json_path;
+			bench::runBVHReport(options.bvh_report);
+			return 0;
+		}
+
+		if (!options.generator.directory.empty())
+		{
+			bench::generateScene(options.generator);
+			return 0;
+		}
+
+		if (!options.convergence.scene_path.empty())
+		{
+			if (options.convergence.reference_path.empty())
+			{
+				throw std::runtime_error("Error: --converge needs a --reference image");
+			}
+			bench::runConvergence(options.convergence);
+			return 0;
+		}
+
+		//End to end renders are slow, so they are run instead of the kernels, once by default.
+		if (!options.render.scene_paths.empty())
+		{
+			options.render.json_path = options.json_path;
+			return bench::runSceneBenchmarks(options.render) ? 0 : 1;
+		}
+
+		//Kernels run on the calling thread. Only BVH builds and scene loading use the pool.
+		core::ThreadPool::configure(options.thread_count);
+
+		bench::Benchmark benchmark(options.filter, options.min_repetition_time, options.numof_repetitions);
+		benchmarkPrimitives(benchmark);
+		benchmarkBVH(benchmark, options);
+		benchmarkScenes(benchmark, options);
+		benchmarkSamplers(benchmark);
+		benchmarkMaterials(benchmark);
+		benchmarkTextures(benchmark, options);
+
+		if (!options.json_path.empty())
+		{
+			benchmark.writeJson(options.json_path);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
\ No newline at end of file
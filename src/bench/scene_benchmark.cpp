@@ -0,0 +1,257 @@
+#include "scene_benchmark.h"
+#include "../core/json.h"
+#include "../core/memory.h"
+#include "../core/scene.h"
+#include "../core/stats.h"
+#include "../core/thread_pool.h"
+#include "../core/timer.h"
+#include "../xml/node.h"
+#include "../xml/parser.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <stdexcept>
+#include <utility>
+
+namespace glue
+{
+	namespace bench
+	{
+		namespace
+		{
+			struct SceneResult
+			{
+				std::string scene;
+				int thread_count;
+				double load_time; //In seconds, including the BVH build.
+				double bvh_build_time;
+				double render_time;
+				double mrays_per_second;
+				double speedup; //Over the single threaded render of the scene.
+			};
+
+			std::vector<std::string> getScenePaths(const std::vector<std::string>& paths)
+			{
+				std::vector<std::string> scene_paths;
+				for (const auto& path : paths)
+				{
+					if (std::filesystem::is_directory(path))
+					{
+						std::vector<std::string> directory_paths;
+						for (const auto& entry : std::filesystem::directory_iterator(path))
+						{
+							if (entry.path().extension() == ".xml")
+							{
+								directory_paths.push_back(entry.path().string());
+							}
+						}
+						std::sort(directory_paths.begin(), directory_paths.end());
+						scene_paths.insert(scene_paths.end(), directory_paths.begin(), directory_paths.end());
+					}
+					else
+					{
+						scene_paths.push_back(path);
+					}
+				}
+
+				return scene_paths;
+			}
+
+			double getMedian(std::vector<double> values)
+			{
+				std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+				return values[values.size() / 2];
+			}
+
+			SceneResult renderScene(const std::string& path, int thread_count, int numof_repetitions)
+			{
+				std::vector<double> load_times;
+				std::vector<double> bvh_build_times;
+				std::vector<double> render_times;
+				std::vector<double> mrays_per_seconds;
+				for (int i = 0; i < numof_repetitions; ++i)
+				{
+					//Every run loads the assets from scratch.
+					xml::Parser::clearCaches();
+					core::stats::reset();
+					core::memory::reset();
+
+					core::Timer timer;
+					core::Scene::Xml scene_xml(xml::Node::getRoot(path));
+					scene_xml.thread_count = thread_count;
+					scene_xml.time_limit = 0.0f;
+					scene_xml.output_interval = 0.0f;
+					scene_xml.checkpoint_path.clear();
+					scene_xml.cost_map_path.clear();
+					scene_xml.outputs.clear();
+					core::Scene scene(scene_xml);
+					load_times.push_back(timer.getTime());
+
+					scene.render();
+
+					auto render_time = core::stats::getPhaseTime("Render");
+					auto numof_rays = core::stats::getTotal(core::stats::Counter::CLOSEST_HIT_RAYS) + core::stats::getTotal(core::stats::Counter::SHADOW_RAYS);
+					bvh_build_times.push_back(core::stats::getPhaseTime("Objects and BVH"));
+					render_times.push_back(render_time);
+					mrays_per_seconds.push_back(render_time > 0.0 ? numof_rays * 1e-6 / render_time : 0.0);
+				}
+
+				return SceneResult{ path, thread_count, getMedian(load_times), getMedian(bvh_build_times), getMedian(render_times), getMedian(mrays_per_seconds), 1.0 };
+			}
+
+			//Reads the render times of a file written by writeJson(), keyed by the escaped scene path and the thread count.
+			std::map<std::pair<std::string, int>, double> readBaseline(const std::string& path)
+			{
+				std::ifstream file(path);
+				if (!file)
+				{
+					throw std::runtime_error("Error: Cannot open the baseline file " + path);
+				}
+
+				static const std::regex cResultPattern(R"re("scene": "((?:[^"\\]|\\.)*)", "threads": (\d+),.*"render_time": ([-+0-9.eE]+))re");
+				std::map<std::pair<std::string, int>, double> render_times;
+				std::string line;
+				std::smatch match;
+				while (std::getline(file, line))
+				{
+					if (std::regex_search(line, match, cResultPattern))
+					{
+						render_times[{ match[1].str(), std::stoi(match[2].str()) }] = std::stod(match[3].str());
+					}
+				}
+
+				return render_times;
+			}
+
+			//One result per line, so that readBaseline() needs no JSON parser.
+			void writeJson(const std::string& path, const std::vector<SceneResult>& results)
+			{
+				std::ofstream file(path);
+				if (!file)
+				{
+					throw std::runtime_error("Error: Cannot open the benchmark file " + path);
+				}
+
+				file << "{\n  \"stats_enabled\": " << (core::stats::cEnabled ? "true" : "false") << ",\n";
+				file << "  \"results\": [";
+				bool first = true;
+				for (const auto& result : results)
+				{
+					file << (first ? "\n" : ",\n") << "    {\"scene\": \"" << core::json::escape(result.scene) << "\", \"threads\": " << result.thread_count <<
+						", \"load_time\": " << result.load_time << ", \"bvh_build_time\": " << result.bvh_build_time <<
+						", \"render_time\": " << result.render_time << ", \"mrays_per_second\": ";
+					//Rays are not counted without GLUE_STATS.
+					if (core::stats::cEnabled)
+					{
+						file << result.mrays_per_second;
+					}
+					else
+					{
+						file << "null";
+					}
+					file << ", \"speedup\": " << result.speedup << "}";
+					first = false;
+				}
+				file << "\n  ]\n}\n";
+			}
+
+			void printResult(const SceneResult& result)
+			{
+				auto flags = std::cout.flags();
+				std::cout << std::left << std::setw(40) << result.scene << std::right << std::setw(4) << result.thread_count << " threads" <<
+					std::fixed << std::setprecision(3) << "  load " << result.load_time << " s  bvh " << result.bvh_build_time <<
+					" s  render " << result.render_time << " s  " << std::setprecision(2);
+				if (core::stats::cEnabled)
+				{
+					std::cout << result.mrays_per_second << " Mrays/s";
+				}
+				else
+				{
+					std::cout << "n/a Mrays/s";
+				}
+				std::cout << "  speedup " << result.speedup << std::endl;
+				std::cout.flags(flags);
+			}
+		}
+
+		bool runSceneBenchmarks(const SceneBenchmarkOptions& options)
+		{
+			std::vector<int> thread_counts;
+			auto max_thread_count = options.max_thread_count > 0 ? options.max_thread_count : core::ThreadPool::getDefaultWorkerCount();
+			for (int thread_count = 1; thread_count < max_thread_count; thread_count *= 2)
+			{
+				thread_counts.push_back(thread_count);
+			}
+			thread_counts.push_back(max_thread_count);
+
+			std::vector<SceneResult> results;
+			for (const auto& path : getScenePaths(options.scene_paths))
+			{
+				//A scene that fails to load, such as one with missing assets, does not stop the others.
+				try
+				{
+					double single_thread_time = 0.0;
+					for (auto thread_count : thread_counts)
+					{
+						auto result = renderScene(path, thread_count, std::max(options.numof_repetitions, 1));
+						if (thread_count == 1)
+						{
+							single_thread_time = result.render_time;
+						}
+						result.speedup = result.render_time > 0.0 ? single_thread_time / result.render_time : 0.0;
+						results.push_back(result);
+					}
+				}
+				catch (const std::exception& e)
+				{
+					std::cout << path << ": " << e.what() << std::endl;
+				}
+			}
+
+			std::cout << std::endl;
+			for (const auto& result : results)
+			{
+				printResult(result);
+			}
+			if (!core::stats::cEnabled)
+			{
+				std::cout << "Mrays/s: Rays are not counted without GLUE_STATS" << std::endl;
+			}
+
+			if (!options.json_path.empty())
+			{
+				writeJson(options.json_path, results);
+			}
+
+			bool passed = true;
+			if (!options.baseline_path.empty())
+			{
+				auto baseline = readBaseline(options.baseline_path);
+				auto flags = std::cout.flags();
+				std::cout << std::endl;
+				for (const auto& result : results)
+				{
+					auto iter = baseline.find({ core::json::escape(result.scene), result.thread_count });
+					if (iter == baseline.end() || iter->second <= 0.0)
+					{
+						continue;
+					}
+
+					auto change = result.render_time / iter->second - 1.0;
+					bool regressed = change > options.regression_threshold;
+					passed = passed && !regressed;
+					std::cout << (regressed ? "REGRESSION " : "ok         ") << result.scene << " with " << result.thread_count << " threads: " <<
+						std::showpos << std::fixed << std::setprecision(1) << change * 100.0 << std::noshowpos << "% render time" << std::endl;
+				}
+				std::cout.flags(flags);
+			}
+
+			return passed;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef __GLUE__BENCH__SCENEBENCHMARK__
+#define __GLUE__BENCH__SCENEBENCHMARK__
+
+#include <string>
+#include <vector>
+
+namespace glue
+{
+	namespace bench
+	{
+		struct SceneBenchmarkOptions
+		{
+			std::vector<std::string> scene_paths; //Directories stand for all of the scenes in them.
+			int max_thread_count; //Scenes are rendered with 1, 2, 4 ... threads up to this.
+			int numof_repetitions; //Medians of the repetitions are reported.
+			std::string json_path;
+			std::string baseline_path; //A JSON file written by an earlier run.
+			float regression_threshold; //Relative increase of the render time over the baseline that counts as a regression.
+		};
+
+		//Renders every scene end to end with the settings of its file, except that outputs, checkpoints,
+		//time limits and cost maps are disabled so that the runs are deterministic and leave no files behind.
+		//Returns false if a run regressed against the baseline.
+		bool runSceneBenchmarks(const SceneBenchmarkOptions& options);
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,289 @@
+#include "scene_generator.h"
+#include "../core/image.h"
+#include "../core/real_sampler.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace glue
+{
+	namespace bench
+	{
+		namespace
+		{
+			//Total flux of each kind of light, shared by the lights of the kind, so that the exposure does not change with their count.
+			constexpr float cTotalFlux = 2000.0f;
+
+			std::ofstream openFile(const std::string& path)
+			{
+				std::ofstream file(path);
+				if (!file)
+				{
+					throw std::runtime_error("Error: Cannot open " + path);
+				}
+
+				return file;
+			}
+
+			glm::vec3 sampleColor(core::RealSampler& sampler)
+			{
+				return glm::vec3(sampler.sample(), sampler.sample(), sampler.sample()) * 0.6f + 0.2f;
+			}
+
+			//Latitude-longitude sphere whose vertices are displaced radially, so that the models differ and are not convex.
+			void writeModel(const std::string& path, int numof_triangles, core::RealSampler& sampler)
+			{
+				auto numof_rings = std::max(2, static_cast<int>(glm::sqrt(numof_triangles / 4.0f)));
+				auto numof_segments = 2 * numof_rings;
+				auto frequency = 2.0f + 6.0f * sampler.sample();
+				auto amplitude = 0.15f * sampler.sample();
+
+				auto file = openFile(path);
+				for (int i = 0; i <= numof_rings; ++i)
+				{
+					auto theta = glm::pi<float>() * i / numof_rings;
+					for (int j = 0; j <= numof_segments; ++j)
+					{
+						auto phi = glm::two_pi<float>() * j / numof_segments;
+						auto radius = 1.0f + amplitude * glm::sin(frequency * theta) * glm::sin(frequency * phi);
+						file << "v " << radius * glm::sin(theta) * glm::cos(phi) << " " << radius * glm::cos(theta) << " " <<
+							radius * glm::sin(theta) * glm::sin(phi) << "\n";
+						file << "vt " << static_cast<float>(j) / numof_segments << " " << 1.0f - static_cast<float>(i) / numof_rings << "\n";
+					}
+				}
+
+				//Indices are 1-based. Triangles that degenerate at the poles are skipped.
+				auto index = [numof_segments](int i, int j) { return i * (numof_segments + 1) + j + 1; };
+				for (int i = 0; i < numof_rings; ++i)
+				{
+					for (int j = 0; j < numof_segments; ++j)
+					{
+						auto v0 = index(i, j), v1 = index(i + 1, j), v2 = index(i + 1, j + 1), v3 = index(i, j + 1);
+						if (i != numof_rings - 1)
+						{
+							file << "f " << v0 << "/" << v0 << " " << v1 << "/" << v1 << " " << v2 << "/" << v2 << "\n";
+						}
+						if (i != 0)
+						{
+							file << "f " << v0 << "/" << v0 << " " << v2 << "/" << v2 << " " << v3 << "/" << v3 << "\n";
+						}
+					}
+				}
+			}
+
+			void writeGround(const std::string& path)
+			{
+				auto file = openFile(path);
+				file << "v -1 0 -1\nv -1 0 1\nv 1 0 1\nv 1 0 -1\n";
+				file << "vt 0 0\nvt 0 1\nvt 1 1\nvt 1 0\n";
+				file << "f 1/1 2/2 3/3\nf 1/1 3/3 4/4\n";
+			}
+
+			//Checkerboard with noise, so that neither mipmaps nor caches see a constant image.
+			void writeTexture(const std::string& path, int size, core::RealSampler& sampler)
+			{
+				auto first = sampleColor(sampler);
+				auto second = sampleColor(sampler);
+				auto cell_size = std::max(1, size / 8);
+
+				core::Image image(size, size, core::Image::Type::BYTE);
+				std::vector<glm::vec3> row(size);
+				for (int j = 0; j < size; ++j)
+				{
+					for (int i = 0; i < size; ++i)
+					{
+						auto color = ((i / cell_size + j / cell_size) % 2) ? first : second;
+						row[i] = color * (0.8f + 0.2f * sampler.sample());
+					}
+					image.setRow(j, row);
+				}
+				image.saveLdr(path);
+			}
+
+			void writeMaterial(std::ofstream& file, int index, const std::vector<std::string>& texture_paths, core::RealSampler& sampler)
+			{
+				file << "\t\t<BsdfMaterial type=\"Lambertian\">\n";
+				if (!texture_paths.empty())
+				{
+					file << "\t\t\t<Kd textureType=\"Image\">\n";
+					file << "\t\t\t\t<Datapath>" << texture_paths[index % texture_paths.size()] << "</Datapath>\n";
+				}
+				else
+				{
+					auto color = sampleColor(sampler);
+					file << "\t\t\t<Kd textureType=\"Constant\">\n";
+					file << "\t\t\t\t<Value>" << color.x << " " << color.y << " " << color.z << "</Value>\n";
+				}
+				file << "\t\t\t</Kd>\n";
+				file << "\t\t</BsdfMaterial>\n";
+			}
+
+			void writeIntegrator(std::ofstream& file, const SceneGeneratorOptions& options)
+			{
+				file << "\t<Integrator type=\"" << options.integrator << "\">\n";
+				file << "\t\t<Filter type=\"Gaussian\">\n";
+				file << "\t\t\t<Sigma>0.5</Sigma>\n";
+				file << "\t\t</Filter>\n";
+				file << "\t\t<SampleCount>" << options.sample_count << "</SampleCount>\n";
+				file << "\t\t<RRThreshold>0.2</RRThreshold>\n";
+				if (options.integrator == "SPPM")
+				{
+					file << "\t\t<PhotonsPerPass>100000</PhotonsPerPass>\n";
+					file << "\t\t<Alpha>0.7</Alpha>\n";
+				}
+				file << "\t</Integrator>\n\n";
+			}
+		}
+
+		std::string generateScene(const SceneGeneratorOptions& options)
+		{
+			if (options.integrator != "Pathtracer" && options.integrator != "SPPM")
+			{
+				throw std::runtime_error("Error: Unknown integrator " + options.integrator);
+			}
+			if (options.numof_mesh_instances > 0 && (options.numof_models <= 0 || options.triangles_per_model <= 0))
+			{
+				throw std::runtime_error("Error: Mesh instances need at least one model with triangles");
+			}
+
+			std::filesystem::create_directories(options.directory);
+			auto getPath = [&options](const std::string& filename) { return (std::filesystem::path(options.directory) / filename).generic_string(); };
+
+			//Every kind of asset has its own sequence, so that changing one count does not move the others.
+			core::PcgSampler model_sampler(0, options.seed);
+			core::PcgSampler texture_sampler(1, options.seed);
+			core::PcgSampler object_sampler(2, options.seed);
+			core::PcgSampler light_sampler(3, options.seed);
+
+			std::vector<std::string> model_paths;
+			for (int i = 0; i < options.numof_models && options.numof_mesh_instances > 0; ++i)
+			{
+				model_paths.push_back(getPath("model_" + std::to_string(i) + ".obj"));
+				writeModel(model_paths.back(), options.triangles_per_model, model_sampler);
+			}
+			auto ground_path = getPath("ground.obj");
+			writeGround(ground_path);
+
+			std::vector<std::string> texture_paths;
+			for (int i = 0; i < options.numof_textures && options.texture_size > 0; ++i)
+			{
+				texture_paths.push_back(getPath("texture_" + std::to_string(i) + ".png"));
+				writeTexture(texture_paths.back(), options.texture_size, texture_sampler);
+			}
+
+			//Half the width of the square the objects are scattered in.
+			auto extent = 2.0f * glm::sqrt(static_cast<float>(options.numof_spheres + options.numof_mesh_instances + 1));
+
+			auto scene_path = getPath("stress.xml");
+			auto file = openFile(scene_path);
+			file << "<Scene>\n";
+			if (options.numof_area_lights + options.numof_point_lights == 0)
+			{
+				file << "\t<BackgroundRadiance>0.5 0.5 0.5</BackgroundRadiance>\n";
+			}
+			file << "\t<SecondaryRayEpsilon>0.001</SecondaryRayEpsilon>\n\n";
+			writeIntegrator(file, options);
+
+			file << "\t<Output type=\"Ldr\">\n";
+			file << "\t\t<Path>" << getPath("stress") << "</Path>\n";
+			file << "\t\t<Format>png</Format>\n";
+			file << "\t\t<Tonemapper type=\"GlobalReinhard\">\n";
+			file << "\t\t\t<Key>0.18</Key>\n";
+			file << "\t\t\t<MaxLuminance>1.0</MaxLuminance>\n";
+			file << "\t\t</Tonemapper>\n";
+			file << "\t</Output>\n\n";
+
+			file << "\t<Camera>\n";
+			file << "\t\t<Position>0 " << extent * 0.8f << " " << extent * 1.6f << "</Position>\n";
+			file << "\t\t<Direction>0 -0.5 -1</Direction>\n";
+			file << "\t\t<Up>0 1 0</Up>\n";
+			file << "\t\t<FovXY>60 60</FovXY>\n";
+			file << "\t\t<Resolution>" << options.resolution << " " << options.resolution << "</Resolution>\n";
+			file << "\t\t<NearDistance>0.01</NearDistance>\n";
+			file << "\t</Camera>\n\n";
+
+			file << "\t<Object type=\"Mesh\">\n";
+			file << "\t\t<Datapath>" << ground_path << "</Datapath>\n";
+			file << "\t\t<Transformation>\n";
+			file << "\t\t\t<Scaling>" << extent * 2.0f << " 1 " << extent * 2.0f << "</Scaling>\n";
+			file << "\t\t</Transformation>\n";
+			writeMaterial(file, 0, texture_paths, object_sampler);
+			file << "\t</Object>\n";
+
+			for (int i = 0; i < options.numof_spheres; ++i)
+			{
+				auto radius = 0.2f + 0.6f * object_sampler.sample();
+				auto x = (2.0f * object_sampler.sample() - 1.0f) * extent;
+				auto z = (2.0f * object_sampler.sample() - 1.0f) * extent;
+				auto y = radius + 2.0f * object_sampler.sample();
+
+				file << "\t<Object type=\"Sphere\">\n";
+				file << "\t\t<Radius>" << radius << "</Radius>\n";
+				file << "\t\t<Center>" << x << " " << y << " " << z << "</Center>\n";
+				writeMaterial(file, i, texture_paths, object_sampler);
+				file << "\t</Object>\n";
+			}
+
+			for (int i = 0; i < options.numof_mesh_instances; ++i)
+			{
+				auto scale = 0.3f + 0.7f * object_sampler.sample();
+				auto x = (2.0f * object_sampler.sample() - 1.0f) * extent;
+				auto z = (2.0f * object_sampler.sample() - 1.0f) * extent;
+				auto y = scale + 2.0f * object_sampler.sample();
+				auto rotation = 360.0f * object_sampler.sample();
+
+				file << "\t<Object type=\"Mesh\">\n";
+				file << "\t\t<Datapath>" << model_paths[i % model_paths.size()] << "</Datapath>\n";
+				file << "\t\t<Transformation>\n";
+				file << "\t\t\t<Scaling>" << scale << " " << scale << " " << scale << "</Scaling>\n";
+				file << "\t\t\t<Rotation>0 " << rotation << " 0</Rotation>\n";
+				file << "\t\t\t<Translation>" << x << " " << y << " " << z << "</Translation>\n";
+				file << "\t\t</Transformation>\n";
+				writeMaterial(file, i, texture_paths, object_sampler);
+				file << "\t</Object>\n";
+			}
+
+			//Lights hang above the objects.
+			for (int i = 0; i < options.numof_area_lights; ++i)
+			{
+				auto flux = cTotalFlux / options.numof_area_lights;
+				auto x = (2.0f * light_sampler.sample() - 1.0f) * extent;
+				auto z = (2.0f * light_sampler.sample() - 1.0f) * extent;
+
+				file << "\t<Light type=\"DiffuseArealight\">\n";
+				file << "\t\t<Flux>" << flux << " " << flux << " " << flux << "</Flux>\n";
+				file << "\t\t<Object type=\"Sphere\">\n";
+				file << "\t\t\t<Radius>0.25</Radius>\n";
+				file << "\t\t\t<Center>" << x << " " << 5.0f << " " << z << "</Center>\n";
+				file << "\t\t</Object>\n";
+				file << "\t</Light>\n";
+			}
+
+			for (int i = 0; i < options.numof_point_lights; ++i)
+			{
+				auto flux = cTotalFlux / options.numof_point_lights;
+				auto x = (2.0f * light_sampler.sample() - 1.0f) * extent;
+				auto z = (2.0f * light_sampler.sample() - 1.0f) * extent;
+
+				file << "\t<Light type=\"Pointlight\">\n";
+				file << "\t\t<Position>" << x << " " << 5.0f << " " << z << "</Position>\n";
+				file << "\t\t<Flux>" << flux << " " << flux << " " << flux << "</Flux>\n";
+				file << "\t</Light>\n";
+			}
+			file << "</Scene>\n";
+
+			std::cout << "Generated " << scene_path << ": " << options.numof_spheres << " spheres, " << options.numof_mesh_instances <<
+				" instances of " << model_paths.size() << " models with about " << options.triangles_per_model << " triangles, " <<
+				options.numof_area_lights << " area lights, " << options.numof_point_lights << " point lights, " << texture_paths.size() <<
+				" textures" << std::endl;
+
+			return scene_path;
+		}
+	}
+}
\ No newline at end of file
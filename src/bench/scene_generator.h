@@ -0,0 +1,35 @@
+#ifndef __GLUE__BENCH__SCENEGENERATOR__
+#define __GLUE__BENCH__SCENEGENERATOR__
+
+#include <cstdint>
+#include <string>
+
+namespace glue
+{
+	namespace bench
+	{
+		struct SceneGeneratorOptions
+		{
+			std::string directory; //Scene, models and textures are written here. Paths in the scene are relative to the working directory, like the sample scenes.
+			std::string integrator; //"Pathtracer" or "SPPM".
+			int numof_spheres;
+			int numof_models; //Distinct models, each loaded and built once.
+			int numof_mesh_instances; //Instances cycle through the models.
+			int triangles_per_model;
+			int numof_area_lights; //Spherical, so that they are emitters in the BVH as well.
+			int numof_point_lights;
+			int numof_textures; //Objects cycle through them. They are not used if the texture size is not positive.
+			int texture_size;
+			int resolution;
+			int sample_count;
+			std::uint64_t seed;
+		};
+
+		//Writes stress.xml with the objects scattered over a ground plane whose area grows with their count,
+		//so that the scene scales without changing its density. The same options and seed always give the same files.
+		//Returns the path of the scene.
+		std::string generateScene(const SceneGeneratorOptions& options);
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,81 @@
+#ifndef __GLUE__CORE__BINARYIO__
+#define __GLUE__CORE__BINARYIO__
+
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace glue
+{
+	namespace core
+	{
+		namespace binary
+		{
+			//Only trivially copyable values are written as raw bytes, so files are meant to be read on the same platform.
+			template<typename T>
+			inline void write(std::ostream& stream, const T& value)
+			{
+				static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be written.");
+				stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+			}
+
+			template<typename T>
+			inline void read(std::istream& stream, T& value)
+			{
+				static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be read.");
+				if (!stream.read(reinterpret_cast<char*>(&value), sizeof(T)))
+				{
+					throw std::runtime_error("Error: Unexpected end of binary file");
+				}
+			}
+
+			template<typename T>
+			inline void writeVector(std::ostream& stream, const std::vector<T>& values)
+			{
+				static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be written.");
+				write(stream, static_cast<std::uint64_t>(values.size()));
+				stream.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+			}
+
+			//Bytes between the read position and the end of the stream. Streams that cannot seek report no limit.
+			inline std::uint64_t getRemainingSize(std::istream& stream)
+			{
+				auto position = stream.tellg();
+				if (position < 0 || !stream.seekg(0, std::ios::end))
+				{
+					stream.clear();
+					return std::numeric_limits<std::uint64_t>::max();
+				}
+				auto end = stream.tellg();
+				stream.seekg(position);
+
+				return static_cast<std::uint64_t>(end - position);
+			}
+
+			//The size is checked against the rest of the stream before anything is allocated,
+			//so that a truncated or corrupt file is reported instead of allocating whatever its size field says.
+			template<typename T>
+			inline void readVector(std::istream& stream, std::vector<T>& values)
+			{
+				static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be read.");
+				std::uint64_t size;
+				read(stream, size);
+				if (size > getRemainingSize(stream) / sizeof(T))
+				{
+					throw std::runtime_error("Error: Corrupt binary file, a vector is longer than the rest of the file");
+				}
+				values.resize(size);
+				if (!stream.read(reinterpret_cast<char*>(values.data()), size * sizeof(T)))
+				{
+					throw std::runtime_error("Error: Unexpected end of binary file");
+				}
+			}
+		}
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "cost_map.h"
+#include "image.h"
+#include "stats.h"
+#include "trace.h"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <array>
+
+namespace glue
+{
+	namespace core
+	{
+		namespace
+		{
+			//Inferno colormap sampled at equal intervals, in sRGB.
+			const std::array<glm::vec3, 5> cPalette{
+				glm::vec3(0.001f, 0.000f, 0.014f),
+				glm::vec3(0.341f, 0.062f, 0.429f),
+				glm::vec3(0.735f, 0.216f, 0.330f),
+				glm::vec3(0.978f, 0.557f, 0.035f),
+				glm::vec3(0.988f, 0.998f, 0.645f)
+			};
+
+			//Returns the linear color of a value in [0, 1].
+			glm::vec3 falseColor(float value)
+			{
+				auto position = glm::clamp(value, 0.0f, 1.0f) * (cPalette.size() - 1);
+				auto index = glm::min(static_cast<int>(position), static_cast<int>(cPalette.size()) - 2);
+				auto srgb = glm::mix(cPalette[index], cPalette[index + 1], position - index);
+
+				//sRGB->Linear since saveLdr applies the inverse.
+				return glm::pow(srgb, glm::vec3(2.2f));
+			}
+		}
+
+		//Probe
+		CostMap::Probe::Probe(CostMap* cost_map)
+			: m_cost_map(cost_map)
+			, m_nodes_visited(0)
+			, m_primitives_tested(0)
+		{
+			if (m_cost_map)
+			{
+				const auto& counters = stats::getThreadCounters().counters;
+				m_nodes_visited = counters[static_cast<int>(stats::Counter::BVH_NODES_VISITED)];
+				m_primitives_tested = counters[static_cast<int>(stats::Counter::PRIMITIVES_TESTED)];
+				m_start = std::chrono::steady_clock::now();
+			}
+		}
+
+		void CostMap::Probe::finish(int x, int y, int numof_samples) const
+		{
+			if (!m_cost_map)
+			{
+				return;
+			}
+
+			const auto& counters = stats::getThreadCounters().counters;
+			auto& pixel = m_cost_map->m_pixels[y * m_cost_map->m_resolution.x + x];
+			pixel.milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+			pixel.nodes_visited += counters[static_cast<int>(stats::Counter::BVH_NODES_VISITED)] - m_nodes_visited;
+			pixel.primitives_tested += counters[static_cast<int>(stats::Counter::PRIMITIVES_TESTED)] - m_primitives_tested;
+			pixel.sample_count += numof_samples;
+		}
+
+		//CostMap
+		CostMap::CostMap(const glm::ivec2& resolution)
+			: m_pixels(resolution.x * resolution.y)
+			, m_resolution(resolution)
+		{}
+
+		void CostMap::save(const std::string& path) const
+		{
+			trace::Scope scope("Save cost map", path);
+			std::vector<float> milliseconds;
+			std::vector<float> nodes_visited;
+			std::vector<float> primitives_tested;
+			for (const auto& pixel : m_pixels)
+			{
+				auto inv_sample_count = pixel.sample_count > 0 ? 1.0f / pixel.sample_count : 0.0f;
+				milliseconds.push_back(static_cast<float>(pixel.milliseconds));
+				nodes_visited.push_back(pixel.nodes_visited * inv_sample_count);
+				primitives_tested.push_back(pixel.primitives_tested * inv_sample_count);
+			}
+
+			saveChannel(path + "-time", milliseconds);
+			saveChannel(path + "-bvh", nodes_visited);
+			saveChannel(path + "-primitives", primitives_tested);
+		}
+
+		void CostMap::saveChannel(const std::string& path, const std::vector<float>& values) const
+		{
+			//The false colors are scaled to the 99th percentile so that a few outliers do not wash out the rest of the image.
+			auto sorted = values;
+			auto percentile = sorted.begin() + (sorted.size() * 99) / 100;
+			float scale = 0.0f;
+			if (percentile != sorted.end())
+			{
+				std::nth_element(sorted.begin(), percentile, sorted.end());
+				scale = *percentile > 0.0f ? 1.0f / *percentile : 0.0f;
+			}
+
+			Image raw(m_resolution.x, m_resolution.y);
+			Image colored(m_resolution.x, m_resolution.y);
+			std::vector<glm::vec3> raw_row(m_resolution.x);
+			std::vector<glm::vec3> colored_row(m_resolution.x);
+			for (int y = 0; y < m_resolution.y; ++y)
+			{
+				for (int x = 0; x < m_resolution.x; ++x)
+				{
+					auto value = values[y * m_resolution.x + x];
+					raw_row[x] = glm::vec3(value);
+					colored_row[x] = falseColor(value * scale);
+				}
+				raw.setRow(y, raw_row);
+				colored.setRow(y, colored_row);
+			}
+
+			raw.saveHdr(path + ".hdr");
+			colored.saveLdr(path + ".png");
+		}
+
+		std::size_t CostMap::getMemoryUsage() const
+		{
+			return m_pixels.capacity() * sizeof(PixelCost);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef __GLUE__CORE__COSTMAP__
+#define __GLUE__CORE__COSTMAP__
+
+#include <glm/vec2.hpp>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace glue
+{
+	namespace core
+	{
+		//Per-pixel render cost, for finding the assets that dominate the render time.
+		//Integrators measure the work they do for a pixel with a Probe. A pixel is only worked on by one thread at a time,
+		//so the pixels need no synchronization.
+		//BVH nodes and primitive tests are read from the counters of core::stats, so they are zero unless the renderer is built with GLUE_STATS.
+		class CostMap
+		{
+		public:
+			//Snapshot of the clock and the traversal counters of the calling thread. It does nothing if there is no cost map,
+			//so that integrators can probe unconditionally.
+			class Probe
+			{
+			public:
+				explicit Probe(CostMap* cost_map);
+
+				//Adds the work done on the calling thread since the construction to the pixel, along with the samples it completes.
+				void finish(int x, int y, int numof_samples) const;
+
+			private:
+				CostMap* m_cost_map;
+				std::chrono::steady_clock::time_point m_start;
+				std::uint64_t m_nodes_visited;
+				std::uint64_t m_primitives_tested;
+			};
+
+		public:
+			explicit CostMap(const glm::ivec2& resolution);
+
+			//Writes <path>-time, <path>-bvh and <path>-primitives, each as an hdr image with the raw values and a false color png.
+			//Times are the total milliseconds spent on the pixel, traversal counts are averaged over its samples.
+			void save(const std::string& path) const;
+			std::size_t getMemoryUsage() const;
+
+		private:
+			struct PixelCost
+			{
+				double milliseconds = 0.0;
+				std::uint64_t nodes_visited = 0;
+				std::uint64_t primitives_tested = 0;
+				int sample_count = 0;
+			};
+
+		private:
+			std::vector<PixelCost> m_pixels; //Indexed by y * resolution.x + x.
+			glm::ivec2 m_resolution;
+
+		private:
+			void saveChannel(const std::string& path, const std::vector<float>& values) const;
+		};
+	}
+}
+
+#endif
\ No newline at end of file
@@ -14,14 +14,24 @@ namespace glue
 			m_sum = m_cdf.back();
 		}
 
-		int Discrete1DSampler::sample(UniformSampler& sampler) const
+		int Discrete1DSampler::sample(RealSampler& sampler) const
 		{
-			return static_cast<int>(std::distance(m_cdf.begin(), std::upper_bound(m_cdf.begin(), m_cdf.end(), sampler.sample() * m_sum)));
+			return sample(sampler.sample());
+		}
+
+		int Discrete1DSampler::sample(float u) const
+		{
+			return static_cast<int>(std::distance(m_cdf.begin(), std::upper_bound(m_cdf.begin(), m_cdf.end(), u * m_sum)));
 		}
 
 		float Discrete1DSampler::getPdf(int x) const
 		{
 			return (x == 0 ? m_cdf[0] : m_cdf[x] - m_cdf[x - 1]) / m_sum;
 		}
+
+		std::size_t Discrete1DSampler::getMemoryUsage() const
+		{
+			return m_cdf.capacity() * sizeof(float);
+		}
 	}
 }
\ No newline at end of file
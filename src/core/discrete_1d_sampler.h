@@ -13,8 +13,11 @@ namespace glue
 			Discrete1DSampler() = default;
 			explicit Discrete1DSampler(const std::vector<float>& pdf);
 
-			int sample(UniformSampler& sampler) const;
+			int sample(RealSampler& sampler) const;
+			//Maps a uniform value in [0, 1) to an index.
+			int sample(float u) const;
 			float getPdf(int x) const;
+			std::size_t getMemoryUsage() const;
 
 			float get_sum() const { return m_sum; }
 
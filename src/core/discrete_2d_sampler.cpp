@@ -17,16 +17,28 @@ namespace glue
 			m_col_sampler = Discrete1DSampler(col_sums);
 		}
 
-		std::pair<int, int> Discrete2DSampler::sample(UniformSampler& sampler) const
+		std::pair<int, int> Discrete2DSampler::sample(RealSampler& sampler) const
 		{
-			auto col = m_col_sampler.sample(sampler);
+			auto u = sampler.get2D();
+			auto col = m_col_sampler.sample(u.x);
 
-			return std::make_pair(col, m_row_samplers[col].sample(sampler));
+			return std::make_pair(col, m_row_samplers[col].sample(u.y));
 		}
 
 		float Discrete2DSampler::getPdf(int x, int y) const
 		{
 			return m_col_sampler.getPdf(x) * m_row_samplers[x].getPdf(y);
 		}
+
+		std::size_t Discrete2DSampler::getMemoryUsage() const
+		{
+			auto bytes = m_col_sampler.getMemoryUsage() + m_row_samplers.capacity() * sizeof(Discrete1DSampler);
+			for (const auto& row_sampler : m_row_samplers)
+			{
+				bytes += row_sampler.getMemoryUsage();
+			}
+
+			return bytes;
+		}
 	}
 }
\ No newline at end of file
@@ -13,8 +13,9 @@ namespace glue
 			Discrete2DSampler() = default;
 			explicit Discrete2DSampler(const std::vector<std::vector<float>>& pdfs);
 
-			std::pair<int, int> sample(UniformSampler& sampler) const;
+			std::pair<int, int> sample(RealSampler& sampler) const;
 			float getPdf(int x, int y) const;
+			std::size_t getMemoryUsage() const;
 
 		private:
 			Discrete1DSampler m_col_sampler;
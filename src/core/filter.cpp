@@ -1,4 +1,5 @@
 #include "filter.h"
+#include "math.h"
 #include "../xml/node.h"
 
 namespace glue
@@ -40,9 +41,9 @@ namespace glue
 		BoxFilter::BoxFilter(const BoxFilter::Xml& xml)
 		{}
 
-		std::unique_ptr<RealSampler> BoxFilter::generateSampler() const
+		float BoxFilter::sampleOffset(float u) const
 		{
-			return std::make_unique<UniformSampler>(-0.5f, 1.5f);
+			return u * 2.0f - 0.5f;
 		}
 
 		//Tent
@@ -57,9 +58,17 @@ namespace glue
 		TentFilter::TentFilter(const TentFilter::Xml& xml)
 		{}
 
-		std::unique_ptr<RealSampler> TentFilter::generateSampler() const
+		float TentFilter::sampleOffset(float u) const
 		{
-			return std::make_unique<TentSampler>(0.5f, 1.0f);
+			auto sample = u * 2.0f - 1.0f;
+			if (sample > 0.0f)
+			{
+				return 1.5f - glm::sqrt(1.0f - sample);
+			}
+			else
+			{
+				return -0.5f + glm::sqrt(1.0f + sample);
+			}
 		}
 
 		//Gaussian
@@ -77,9 +86,10 @@ namespace glue
 			: m_sigma(xml.sigma)
 		{}
 
-		std::unique_ptr<RealSampler> GaussianFilter::generateSampler() const
+		float GaussianFilter::sampleOffset(float u) const
 		{
-			return std::make_unique<GaussianSampler>(0.5f, m_sigma);
+			//Inverse of the normal cdf.
+			return 0.5f + m_sigma * glm::root_two<float>() * math::inverseErf(glm::clamp(u * 2.0f - 1.0f, -0.99999f, 0.99999f));
 		}
 	}
 }
\ No newline at end of file
@@ -2,7 +2,6 @@
 #define __GLUE__CORE__FILTER__
 
 #include "../core/forward_decl.h"
-#include "real_sampler.h"
 
 #include <memory>
 
@@ -24,7 +23,8 @@ namespace glue
 		public:
 			virtual ~Filter() = default;
 
-			virtual std::unique_ptr<RealSampler> generateSampler() const = 0;
+			//Maps a uniform sample in [0, 1) to a pixel offset distributed by the filter.
+			virtual float sampleOffset(float u) const = 0;
 		};
 
 		class BoxFilter : public Filter
@@ -40,7 +40,7 @@ namespace glue
 		public:
 			explicit BoxFilter(const BoxFilter::Xml& xml);
 
-			std::unique_ptr<RealSampler> generateSampler() const override;
+			float sampleOffset(float u) const override;
 		};
 
 		class TentFilter : public Filter
@@ -56,7 +56,7 @@ namespace glue
 		public:
 			explicit TentFilter(const TentFilter::Xml& xml);
 
-			std::unique_ptr<RealSampler> generateSampler() const override;
+			float sampleOffset(float u) const override;
 		};
 
 		class GaussianFilter : public Filter
@@ -74,7 +74,7 @@ namespace glue
 		public:
 			explicit GaussianFilter(const GaussianFilter::Xml& xml);
 
-			std::unique_ptr<RealSampler> generateSampler() const override;
+			float sampleOffset(float u) const override;
 
 		private:
 			float m_sigma;
@@ -13,13 +13,16 @@ namespace glue
 		class TentFilter;
 		class GaussianFilter;
 		class RealSampler;
+		class Sampler;
+		class IndependentSampler;
+		class HaltonSampler;
+		class Sobol2DSampler;
 		class UniformSampler;
-		class TentSampler;
-		class GaussianSampler;
 		class Image;
 		class Output;
 		class Ldr;
 		class PinholeCamera;
+		struct RenderJob;
 		struct Scene;
 		class Timer;
 		class Tonemapper;
@@ -36,6 +39,7 @@ namespace glue
 		class Mesh;
 		struct Plane;
 		class Ray;
+		struct RayCone;
 		struct SphericalCoordinate;
 		class Transformation;
 		class Triangle;
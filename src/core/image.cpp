@@ -10,191 +10,124 @@
 #define STBIR_DEFAULT_FILTER_DOWNSAMPLE STBIR_FILTER_TRIANGLE //Avoids ringing.
 #include <stb_image_resize.h>
 
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
 namespace glue
 {
 	namespace core
 	{
-		template<typename T, int tMax, ImageReprBase::Type tType>
-		ImageRepr<T, tMax, tType>::ImageRepr(int width, int height)
-			: m_pixels(width, std::vector<RGB>(height))
-		{}
+		//Pixel buffers are handed to stb as arrays of floats.
+		static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "glm::vec3 must not be padded.");
 
-		template<typename T, int tMax, ImageReprBase::Type tType>
-		ImageRepr<T, tMax, tType>::ImageRepr(const std::string& filename)
+		Image::Image(int width, int height, Type type)
+			: m_width(width)
+			, m_height(height)
+			, m_type(type)
 		{
-			//If given image is LDR, stbi_loadf applies an sRGB->Linear conversion.
-			int channel;
-			int width;
-			int height;
-			auto data = stbi_loadf(filename.c_str(), &width, &height, &channel, 0);
-
-			if (!data)
+			switch (type)
 			{
-				throw std::runtime_error("Error: Image cannot be loaded");
-			}
+			case Type::BYTE:
+				m_byte_pixels.resize(width * height, BytePixel{ 0, 0, 0 });
+				break;
 
-			m_pixels.resize(width, std::vector<RGB>(height));
-			for (int j = 0, index = 0; j < height; ++j)
-			{
-				for (int i = 0; i < width; ++i, index += channel)
-				{
-					set(i, j, glm::vec3(data[index], data[index + 1], data[index + 2]));
-				}
+			case Type::FLOAT:
+				m_float_pixels.resize(width * height, glm::vec3(0.0f));
+				break;
 			}
-
-			stbi_image_free(data);
 		}
 
-		template<typename T, int tMax, ImageReprBase::Type tType>
-		void ImageRepr<T, tMax, tType>::set(int x, int y, const glm::vec3& value)
+		Image::Image(const std::string& filename)
+			: m_type(stbi_is_hdr(filename.c_str()) ? Type::FLOAT : Type::BYTE)
 		{
-			if constexpr (tMax == 1)
-			{
-				m_pixels[x][y] = RGB(static_cast<T>(value.x), static_cast<T>(value.y), static_cast<T>(value.z));
-			}
-			else
+			//If given image is LDR, stbi_loadf applies an sRGB->Linear conversion.
+			//Images with fewer channels are expanded to RGB, so the data has the layout of the pixels.
+			constexpr int channel = 3; //RGB
+			int file_channel;
+			auto data = stbi_loadf(filename.c_str(), &m_width, &m_height, &file_channel, channel);
+
+			if (!data)
 			{
-				constexpr float max = tMax;
-				m_pixels[x][y] = RGB(static_cast<T>(value.x * max), static_cast<T>(value.y * max), static_cast<T>(value.z * max));
+				throw std::runtime_error("Error: Image cannot be loaded");
 			}
-		}
 
-		template<typename T, int tMax, ImageReprBase::Type tType>
-		glm::vec3 ImageRepr<T, tMax, tType>::get(int x, int y) const
-		{
-			if constexpr (tMax == 1)
+			auto pixels = reinterpret_cast<const glm::vec3*>(data);
+			if (m_type == Type::FLOAT)
 			{
-				const auto& value = m_pixels[x][y];
-				return glm::vec3(value.r, value.g, value.b);
+				m_float_pixels.assign(pixels, pixels + m_width * m_height);
 			}
 			else
 			{
-				constexpr float inv_max = 1.0f / tMax;
-				const auto& value = m_pixels[x][y];
-				return glm::vec3(value.r, value.g, value.b) * inv_max;
+				m_byte_pixels.resize(m_width * m_height);
+				std::transform(pixels, pixels + m_width * m_height, m_byte_pixels.begin(), toBytePixel);
 			}
-		}
-
-		template<typename T, int tMax, ImageReprBase::Type tType>
-		ImageReprBase::Type ImageRepr<T, tMax, tType>::type() const
-		{
-			return tType;
-		}
 
-		template<typename T, int tMax, ImageReprBase::Type tType>
-		std::unique_ptr<ImageReprBase> ImageRepr<T, tMax, tType>::clone() const
-		{
-			return std::make_unique<ImageRepr<T, tMax, tType>>(*this);
+			stbi_image_free(data);
 		}
 
-		Image::Image(int width, int height, ImageReprBase::Type type)
-			: m_image_repr(nullptr)
-			, m_width(width)
-			, m_height(height)
+		void Image::getRow(int y, Span<glm::vec3> values, int x) const
 		{
-			switch (type)
+			auto index = y * m_width + x;
+			if (m_type == Type::FLOAT)
 			{
-			case ImageReprBase::Type::BYTE:
-				m_image_repr = std::make_unique<ByteImage>(width, height);
-				break;
-
-			case ImageReprBase::Type::FLOAT:
-				m_image_repr = std::make_unique<FloatImage>(width, height);
-				break;
+				std::copy(m_float_pixels.begin() + index, m_float_pixels.begin() + index + values.size(), values.begin());
+			}
+			else
+			{
+				std::transform(m_byte_pixels.begin() + index, m_byte_pixels.begin() + index + values.size(), values.begin(), toFloatPixel);
 			}
 		}
 
-		Image::Image(const std::string& filename)
-			: m_image_repr(nullptr)
+		void Image::setRow(int y, Span<const glm::vec3> values, int x)
 		{
-			if (stbi_is_hdr(filename.c_str()))
+			auto index = y * m_width + x;
+			if (m_type == Type::FLOAT)
 			{
-				m_image_repr = std::make_unique<FloatImage>(filename);
+				std::copy(values.begin(), values.end(), m_float_pixels.begin() + index);
 			}
 			else
 			{
-				m_image_repr = std::make_unique<ByteImage>(filename);
+				std::transform(values.begin(), values.end(), m_byte_pixels.begin() + index, toBytePixel);
 			}
-
-			int channel;
-			stbi_info(filename.c_str(), &m_width, &m_height, &channel);
-		}
-
-		Image::Image(const Image& image)
-			: m_image_repr(image.m_image_repr->clone())
-			, m_width(image.m_width)
-			, m_height(image.m_height)
-		{}
-
-		Image& Image::operator=(const Image& image)
-		{
-			m_image_repr = image.m_image_repr->clone();
-			m_width = image.m_width;
-			m_height = image.m_height;
-
-			return *this;
 		}
 
-		void Image::set(int x, int y, const glm::vec3& value)
+		std::size_t Image::getMemoryUsage() const
 		{
-			m_image_repr->set(x, y, value);
-		}
-
-		glm::vec3 Image::get(int x, int y) const
-		{
-			return m_image_repr->get(x, y);
+			return m_float_pixels.capacity() * sizeof(glm::vec3) + m_byte_pixels.capacity() * sizeof(BytePixel);
 		}
 
 		std::vector<Image> Image::generateMipmaps() const
 		{
 			constexpr int channel = 3; //RGB
+			std::vector<Image> mipmaps(1, *this);
+			std::vector<glm::vec3> src(m_width * m_height);
+			for (int j = 0; j < m_height; ++j)
+			{
+				getRow(j, Span<glm::vec3>(src.data() + j * m_width, m_width));
+			}
+
+			//Every level halves the previous one, rounding down, until a single texel is left.
 			int src_width = m_width;
 			int src_height = m_height;
-			int dest_width = core::math::closestPowTwo(m_width);
-			int dest_height = core::math::closestPowTwo(m_height);
-			int stride_src = channel * src_width * sizeof(float);
-			int stride_dest = channel * dest_width * sizeof(float);
-			std::unique_ptr<float[]> src(new float[channel * src_width * src_height]);
-			std::unique_ptr<float[]> dest(new float[channel * dest_width * dest_height]);
-			auto src_ptr = src.get();
-
-			for (int j = 0, index = 0; j < m_height; ++j)
+			while (src_width > 1 || src_height > 1)
 			{
-				for (int i = 0; i < m_width; ++i, index += channel)
+				int dest_width = glm::max(src_width / 2, 1);
+				int dest_height = glm::max(src_height / 2, 1);
+				std::vector<glm::vec3> dest(dest_width * dest_height);
+				stbir_resize_float(reinterpret_cast<const float*>(src.data()), src_width, src_height, channel * src_width * sizeof(float),
+					reinterpret_cast<float*>(dest.data()), dest_width, dest_height, channel * dest_width * sizeof(float), channel);
+
+				Image mipmap(dest_width, dest_height, m_type);
+				for (int j = 0; j < dest_height; ++j)
 				{
-					auto pixel = get(i, j);
-
-					src_ptr[index] = pixel.x;
-					src_ptr[index + 1] = pixel.y;
-					src_ptr[index + 2] = pixel.z;
+					mipmap.setRow(j, Span<const glm::vec3>(dest.data() + j * dest_width, dest_width));
 				}
-			}
-
-			std::vector<Image> mipmaps;
-			while (dest_width >= 1 && dest_height >= 1)
-			{
-				stbir_resize_float(src.get(), src_width, src_height, stride_src, dest.get(), dest_width, dest_height, stride_dest, channel);
+				mipmaps.push_back(std::move(mipmap));
 
+				src = std::move(dest);
 				src_width = dest_width;
 				src_height = dest_height;
-				dest_width >>= 1;
-				dest_height >>= 1;
-				stride_src = channel * src_width * sizeof(float);
-				stride_dest = channel * dest_width * sizeof(float);
-				src = std::move(dest);
-				dest = std::unique_ptr<float[]>(new float[channel * dest_width * dest_height]);
-				src_ptr = src.get();
-
-				Image mipmap(src_width, src_height, m_image_repr->type());
-				for (int j = 0, index = 0; j < src_height; ++j)
-				{
-					for (int i = 0; i < src_width; ++i, index += channel)
-					{
-						mipmap.set(i, j, glm::vec3(src_ptr[index], src_ptr[index + 1], src_ptr[index + 2]));
-					}
-				}
-
-				mipmaps.push_back(std::move(mipmap));
 			}
 
 			return mipmaps;
@@ -206,12 +139,14 @@ namespace glue
 			int stride = channel * m_width;
 			std::unique_ptr<unsigned char[]> data(new unsigned char[stride * m_height]);
 			auto data_ptr = data.get();
+			std::vector<glm::vec3> row(m_width);
 
 			for (int j = 0, index = 0; j < m_height; ++j)
 			{
+				getRow(j, row);
 				for (int i = 0; i < m_width; ++i, index += channel)
 				{
-					auto pixel = get(i, j);
+					auto pixel = row[i];
 
 					//Linear->sRGB
 					pixel.x = glm::pow(pixel.x, 0.45454545f);
@@ -241,5 +176,20 @@ namespace glue
 				stbi_write_tga(filename.c_str(), m_width, m_height, channel, data_ptr);
 			}
 		}
+
+		void Image::saveHdr(const std::string& filename) const
+		{
+			constexpr int channel = 3; //RGB
+			std::vector<glm::vec3> data(m_width * m_height);
+			for (int j = 0; j < m_height; ++j)
+			{
+				getRow(j, Span<glm::vec3>(data.data() + j * m_width, m_width));
+			}
+
+			if (!stbi_write_hdr(filename.c_str(), m_width, m_height, channel, reinterpret_cast<const float*>(data.data())))
+			{
+				throw std::runtime_error("Error: Cannot save the image " + filename);
+			}
+		}
 	}
 }
\ No newline at end of file
@@ -1,16 +1,19 @@
 #ifndef __GLUE__CORE__IMAGE__
 #define __GLUE__CORE__IMAGE__
 
+#include "span.h"
+
 #include <glm/vec3.hpp>
 #include <vector>
 #include <string>
-#include <memory>
 
 namespace glue
 {
 	namespace core
 	{
-		class ImageReprBase
+		//Pixels are stored row by row in a single allocation, so the pixel (x, y) is at y * width + x.
+		//Byte images keep the linear values scaled to [0, 255]. Float images keep them as they are.
+		class Image
 		{
 		public:
 			enum class Type
@@ -19,71 +22,49 @@ namespace glue
 				FLOAT
 			};
 
-		public:
-			virtual ~ImageReprBase() = default;
-
-			virtual void set(int x, int y, const glm::vec3& value) = 0;
-			virtual glm::vec3 get(int x, int y) const = 0;
-			virtual Type type() const = 0;
-			virtual std::unique_ptr<ImageReprBase> clone() const = 0;
-		};
-
-		template<typename T, int tMax, ImageReprBase::Type tType>
-		class ImageRepr : public ImageReprBase
-		{
-		public:
-			struct RGB
+			struct BytePixel
 			{
-				T r, g, b;
-
-				RGB() = default;
-				RGB(T p_r, T p_g, T p_b)
-					: r(p_r)
-					, g(p_g)
-					, b(p_b)
-				{}
+				unsigned char r, g, b;
 			};
 
 		public:
-			ImageRepr(int width, int height);
-			explicit ImageRepr(const std::string& filename);
-
-			void set(int x, int y, const glm::vec3& value) override;
-			glm::vec3 get(int x, int y) const override;
-			ImageReprBase::Type type() const override;
-			std::unique_ptr<ImageReprBase> clone() const override;
-
-		private:
-			std::vector<std::vector<RGB>> m_pixels;
-		};
-
-		using ByteImage = ImageRepr<unsigned char, 255, ImageReprBase::Type::BYTE>;
-		using FloatImage = ImageRepr<float, 1, ImageReprBase::Type::FLOAT>;
-
-		class Image
-		{
-		public:
-			Image(int width, int height, ImageReprBase::Type type = ImageReprBase::Type::FLOAT);
+			Image(int width, int height, Type type = Type::FLOAT);
 			explicit Image(const std::string& filename);
-			Image(const Image& image);
-			Image(Image&& image) = default;
-			Image& operator=(const Image& image);
-			Image& operator=(Image&& image) = default;
 
-			void set(int x, int y, const glm::vec3& value);
 			glm::vec3 get(int x, int y) const;
+			void set(int x, int y, const glm::vec3& value);
+			//Bulk access to values.size() pixels of the row, starting from x. It checks the type once instead of per pixel.
+			void getRow(int y, Span<glm::vec3> values, int x = 0) const;
+			void setRow(int y, Span<const glm::vec3> values, int x = 0);
 			std::vector<Image> generateMipmaps() const;
 			void saveLdr(const std::string& filename) const;
+			//Saves the linear values in Radiance HDR format.
+			void saveHdr(const std::string& filename) const;
+			std::size_t getMemoryUsage() const;
 
 			int get_width() const { return m_width; }
 			int get_height() const { return m_height; }
+			Type get_type() const { return m_type; }
+			//Typed views of the storage. The one that does not match the type of the image is empty.
+			Span<glm::vec3> get_float_pixels() { return m_float_pixels; }
+			Span<const glm::vec3> get_float_pixels() const { return m_float_pixels; }
+			Span<BytePixel> get_byte_pixels() { return m_byte_pixels; }
+			Span<const BytePixel> get_byte_pixels() const { return m_byte_pixels; }
 
 		private:
-			std::unique_ptr<ImageReprBase> m_image_repr;
+			std::vector<glm::vec3> m_float_pixels;
+			std::vector<BytePixel> m_byte_pixels;
 			int m_width;
 			int m_height;
+			Type m_type;
+
+		private:
+			static BytePixel toBytePixel(const glm::vec3& value);
+			static glm::vec3 toFloatPixel(const BytePixel& pixel);
 		};
 	}
 }
 
+#include "image.inl"
+
 #endif
\ No newline at end of file
@@ -0,0 +1,36 @@
+namespace glue
+{
+	namespace core
+	{
+		inline glm::vec3 Image::get(int x, int y) const
+		{
+			auto index = y * m_width + x;
+			return m_type == Type::FLOAT ? m_float_pixels[index] : toFloatPixel(m_byte_pixels[index]);
+		}
+
+		inline void Image::set(int x, int y, const glm::vec3& value)
+		{
+			auto index = y * m_width + x;
+			if (m_type == Type::FLOAT)
+			{
+				m_float_pixels[index] = value;
+			}
+			else
+			{
+				m_byte_pixels[index] = toBytePixel(value);
+			}
+		}
+
+		inline Image::BytePixel Image::toBytePixel(const glm::vec3& value)
+		{
+			constexpr float max = 255.0f;
+			return BytePixel{ static_cast<unsigned char>(value.x * max), static_cast<unsigned char>(value.y * max), static_cast<unsigned char>(value.z * max) };
+		}
+
+		inline glm::vec3 Image::toFloatPixel(const BytePixel& pixel)
+		{
+			constexpr float inv_max = 1.0f / 255.0f;
+			return glm::vec3(pixel.r, pixel.g, pixel.b) * inv_max;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#ifndef __GLUE__CORE__JSON__
+#define __GLUE__CORE__JSON__
+
+#include <string>
+
+namespace glue
+{
+	namespace core
+	{
+		namespace json
+		{
+			//Escapes the text to be written inside a JSON string. Control characters are dropped.
+			inline std::string escape(const std::string& text)
+			{
+				std::string escaped;
+				for (auto c : text)
+				{
+					if (c == '"' || c == '\\')
+					{
+						escaped += '\\';
+					}
+					if (static_cast<unsigned char>(c) >= 0x20)
+					{
+						escaped += c;
+					}
+				}
+
+				return escaped;
+			}
+		}
+	}
+}
+
+#endif
\ No newline at end of file
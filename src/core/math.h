@@ -3,10 +3,12 @@
 
 #include "../geometry/spherical_coordinate.h"
 
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/geometric.hpp>
 #include <glm/gtc/constants.hpp>
 #include <glm/trigonometric.hpp>
+#include <cstdint>
 
 namespace glue
 {
@@ -48,6 +50,27 @@ namespace glue
 				return p * x;
 			}
 
+			//Integer hash with good avalanche behaviour, from "Prospecting for Hash Functions" by Chris Wellons.
+			inline std::uint32_t hash(std::uint32_t x)
+			{
+				x ^= x >> 16;
+				x *= 0x7feb352du;
+				x ^= x >> 15;
+				x *= 0x846ca68bu;
+				x ^= x >> 16;
+				return x;
+			}
+
+			inline std::uint32_t reverseBits(std::uint32_t x)
+			{
+				x = (x << 16) | (x >> 16);
+				x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+				x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+				x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+				x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+				return x;
+			}
+
 			inline unsigned int closestPowTwo(unsigned int number)
 			{
 				auto v = number;
@@ -119,6 +142,14 @@ namespace glue
 			{
 				return geometry::SphericalCoordinate(1.0f, glm::acos(1.0f - 2.0f * u1), glm::two_pi<float>() * u2);
 			}
+
+			//Returns a point on the unit disk.
+			inline glm::vec2 sampleDiskUniform(float u1, float u2)
+			{
+				auto r = glm::sqrt(u1);
+				auto phi = glm::two_pi<float>() * u2;
+				return glm::vec2(r * glm::cos(phi), r * glm::sin(phi));
+			}
 		}
 	}
 }
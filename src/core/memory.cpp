@@ -0,0 +1,137 @@
+#include "memory.h"
+#include "json.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace glue
+{
+	namespace core
+	{
+		namespace memory
+		{
+			namespace
+			{
+				using Entries = std::map<std::pair<std::string, std::string>, std::size_t>; //Keyed by category and name.
+
+				std::mutex gMutex;
+				Entries gEntries;
+				Entries gPeakEntries;
+				std::size_t gTotal = 0;
+				std::size_t gPeak = 0;
+
+				//Entries are few and change rarely, so a copy is taken whenever the total reaches a new peak.
+				void update(std::size_t& bytes, std::size_t new_bytes)
+				{
+					gTotal = gTotal - bytes + new_bytes;
+					bytes = new_bytes;
+					if (gTotal > gPeak)
+					{
+						gPeak = gTotal;
+						gPeakEntries = gEntries;
+					}
+				}
+
+				std::vector<std::pair<Entries::key_type, std::size_t>> getSorted(const Entries& entries)
+				{
+					std::vector<std::pair<Entries::key_type, std::size_t>> sorted(entries.begin(), entries.end());
+					std::stable_sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+
+					return sorted;
+				}
+			}
+
+			void set(const std::string& category, const std::string& name, std::size_t bytes)
+			{
+				std::lock_guard<std::mutex> lock(gMutex);
+				update(gEntries[{ category, name }], bytes);
+			}
+
+			void add(const std::string& category, const std::string& name, std::size_t bytes)
+			{
+				std::lock_guard<std::mutex> lock(gMutex);
+				auto& entry = gEntries[{ category, name }];
+				update(entry, entry + bytes);
+			}
+
+			void reset()
+			{
+				std::lock_guard<std::mutex> lock(gMutex);
+				gEntries.clear();
+				gPeakEntries.clear();
+				gTotal = 0;
+				gPeak = 0;
+			}
+
+			std::size_t getTotal()
+			{
+				std::lock_guard<std::mutex> lock(gMutex);
+				return gTotal;
+			}
+
+			std::size_t getPeak()
+			{
+				std::lock_guard<std::mutex> lock(gMutex);
+				return gPeak;
+			}
+
+			void printReport(std::ostream& stream, bool at_peak)
+			{
+				constexpr int cMaxEntries = 10;
+				constexpr double cMegabyte = 1024.0 * 1024.0;
+
+				std::lock_guard<std::mutex> lock(gMutex);
+				const auto& entries = at_peak ? gPeakEntries : gEntries;
+				std::map<std::string, std::size_t> category_totals;
+				for (const auto& entry : entries)
+				{
+					category_totals[entry.first.first] += entry.second;
+				}
+				std::vector<std::pair<std::string, std::size_t>> categories(category_totals.begin(), category_totals.end());
+				std::stable_sort(categories.begin(), categories.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+
+				auto flags = stream.flags();
+				stream << std::fixed << std::setprecision(2);
+				stream << (at_peak ? "Peak memory: " : "Memory: ") << (at_peak ? gPeak : gTotal) / cMegabyte << " MB" << std::endl;
+				for (const auto& category : categories)
+				{
+					stream << "  " << category.first << ": " << category.second / cMegabyte << " MB" << std::endl;
+				}
+
+				auto sorted = getSorted(entries);
+				int numof_entries = std::min(static_cast<int>(sorted.size()), cMaxEntries);
+				if (numof_entries > 0)
+				{
+					stream << "  Largest:" << std::endl;
+				}
+				for (int i = 0; i < numof_entries; ++i)
+				{
+					stream << "    " << sorted[i].second / cMegabyte << " MB  " << sorted[i].first.first << " " << sorted[i].first.second << std::endl;
+				}
+				stream.flags(flags);
+			}
+
+			void writeJson(std::ostream& stream, const std::string& indent)
+			{
+				std::lock_guard<std::mutex> lock(gMutex);
+				stream << "{\n";
+				stream << indent << "  \"current_bytes\": " << gTotal << ",\n";
+				stream << indent << "  \"peak_bytes\": " << gPeak << ",\n";
+				stream << indent << "  \"peak_entries\": [";
+				bool first = true;
+				for (const auto& entry : getSorted(gPeakEntries))
+				{
+					stream << (first ? "\n" : ",\n") << indent << "    {\"category\": \"" << json::escape(entry.first.first) << "\", \"name\": \"" <<
+						json::escape(entry.first.second) << "\", \"bytes\": " << entry.second << "}";
+					first = false;
+				}
+				stream << "\n" << indent << "  ]\n";
+				stream << indent << "}";
+			}
+		}
+	}
+}
\ No newline at end of file
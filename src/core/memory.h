@@ -0,0 +1,36 @@
+#ifndef __GLUE__CORE__MEMORY__
+#define __GLUE__CORE__MEMORY__
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+namespace glue
+{
+	namespace core
+	{
+		//Bytes held by the large allocations of the renderer such as BVHs, textures and integrator buffers,
+		//so that a render that runs out of memory can be traced back to an asset.
+		//Entries are reported by the owners of the allocations and are identified by their category and name.
+		namespace memory
+		{
+			//Replaces the bytes of the entry.
+			void set(const std::string& category, const std::string& name, std::size_t bytes);
+			//Adds to the bytes of the entry, so that the instances of an asset add up.
+			void add(const std::string& category, const std::string& name, std::size_t bytes);
+
+			//Removes all of the entries and the peak.
+			void reset();
+
+			std::size_t getTotal();
+			std::size_t getPeak();
+
+			//Prints the totals of the categories and the largest entries, at the moment or at the peak of the total.
+			void printReport(std::ostream& stream, bool at_peak);
+			//Writes the entries at the peak as a JSON object.
+			void writeJson(std::ostream& stream, const std::string& indent);
+		}
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "numa.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace glue
+{
+	namespace core
+	{
+		namespace
+		{
+			//Parses cpu lists of sysfs such as "0-7,16-23".
+			std::vector<int> parseCpuList(const std::string& list)
+			{
+				std::vector<int> cpus;
+				std::stringstream stream(list);
+				std::string range;
+				while (std::getline(stream, range, ','))
+				{
+					if (range.empty() || range == "\n")
+					{
+						continue;
+					}
+					auto dash = range.find('-');
+					auto first = std::stoi(range.substr(0, dash));
+					auto last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+					for (int cpu = first; cpu <= last; ++cpu)
+					{
+						cpus.push_back(cpu);
+					}
+				}
+
+				return cpus;
+			}
+		}
+
+		NumaTopology::NumaTopology()
+		{
+#ifdef __linux__
+			//Cpus outside of the affinity mask of the process, for example in a cpuset, are left out.
+			cpu_set_t allowed;
+			CPU_ZERO(&allowed);
+			bool has_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+			//Node ids may have gaps, so a few missing nodes are tolerated before giving up.
+			for (int id = 0, missing = 0; missing < 8; ++id)
+			{
+				std::ifstream file("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+				std::string list;
+				if (!file || !std::getline(file, list))
+				{
+					++missing;
+					continue;
+				}
+
+				NumaNode node{ id, {} };
+				for (auto cpu : parseCpuList(list))
+				{
+					if (!has_mask || CPU_ISSET(cpu, &allowed))
+					{
+						node.cpus.push_back(cpu);
+					}
+				}
+				if (!node.cpus.empty())
+				{
+					m_nodes.push_back(std::move(node));
+				}
+			}
+#endif
+			if (m_nodes.empty())
+			{
+				NumaNode node{ 0, {} };
+				int numof_cpus = std::max(1u, std::thread::hardware_concurrency());
+				for (int cpu = 0; cpu < numof_cpus; ++cpu)
+				{
+					node.cpus.push_back(cpu);
+				}
+				m_nodes.push_back(std::move(node));
+			}
+
+			int numof_nodes = m_nodes.size();
+			for (int i = 0; i < numof_nodes; ++i)
+			{
+				m_worker_nodes.insert(m_worker_nodes.end(), m_nodes[i].cpus.size(), i);
+			}
+		}
+
+		int NumaTopology::getNodeOfWorker(int worker) const
+		{
+			return m_worker_nodes[worker % m_worker_nodes.size()];
+		}
+
+		bool NumaTopology::pinCurrentThreadToNode(int node) const
+		{
+#ifdef __linux__
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			for (auto cpu : m_nodes[node].cpus)
+			{
+				CPU_SET(cpu, &cpus);
+			}
+			return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+			return false;
+#endif
+		}
+
+		bool NumaTopology::setInterleaved(bool interleaved) const
+		{
+#ifdef __linux__
+			//Called through syscall() so that libnuma is not needed.
+			if (!interleaved)
+			{
+				return syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0) == 0;
+			}
+
+			unsigned long mask = 0;
+			for (const auto& node : m_nodes)
+			{
+				if (node.id < static_cast<int>(sizeof(mask) * 8))
+				{
+					mask |= 1ul << node.id;
+				}
+			}
+			return syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, &mask, sizeof(mask) * 8 + 1) == 0;
+#else
+			return false;
+#endif
+		}
+
+		NumaPolicy NumaTopology::parsePolicy(const std::string& policy)
+		{
+			if (policy == "None")
+			{
+				return NumaPolicy::NONE;
+			}
+			else if (policy == "Pin")
+			{
+				return NumaPolicy::PIN;
+			}
+			else if (policy == "Interleave")
+			{
+				return NumaPolicy::INTERLEAVE;
+			}
+			else if (policy == "Replicate")
+			{
+				return NumaPolicy::REPLICATE;
+			}
+
+			throw std::runtime_error("Error: Unknown NumaPolicy " + policy);
+		}
+	}
+}
\ No newline at end of file
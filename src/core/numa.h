@@ -0,0 +1,49 @@
+#ifndef __GLUE__CORE__NUMA__
+#define __GLUE__CORE__NUMA__
+
+#include <string>
+#include <vector>
+
+namespace glue
+{
+	namespace core
+	{
+		enum class NumaPolicy
+		{
+			NONE, //Threads are not pinned and memory is first-touched by the loading thread.
+			PIN, //Workers are pinned to the cpus of their nodes.
+			INTERLEAVE, //Workers are pinned and the scene is loaded by a single thread that interleaves its pages across the nodes.
+			REPLICATE //Workers are pinned and every node gets its own copy of the objects and the BVH.
+		};
+
+		struct NumaNode
+		{
+			int id;
+			std::vector<int> cpus;
+		};
+
+		//Topology is read from sysfs on Linux. Other platforms and machines without NUMA are treated as a single node of all cpus.
+		class NumaTopology
+		{
+		public:
+			NumaTopology();
+
+			//Workers are spread over the cpus node by node, so consecutive workers share a node until it is full.
+			int getNodeOfWorker(int worker) const;
+			//Threads created afterwards by the calling thread inherit the affinity. Returns false if it could not be set.
+			bool pinCurrentThreadToNode(int node) const;
+			//Pages allocated by the calling thread are interleaved across all nodes until it is disabled.
+			bool setInterleaved(bool interleaved) const;
+
+			const std::vector<NumaNode>& get_nodes() const { return m_nodes; }
+
+			static NumaPolicy parsePolicy(const std::string& policy);
+
+		private:
+			std::vector<NumaNode> m_nodes;
+			std::vector<int> m_worker_nodes; //Node index of every cpu in node order.
+		};
+	}
+}
+
+#endif
\ No newline at end of file
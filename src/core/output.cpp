@@ -1,4 +1,5 @@
 #include "output.h"
+#include "trace.h"
 #include "../xml/parser.h"
 
 namespace glue
@@ -45,6 +46,7 @@ namespace glue
 
 		void Ldr::save(const Image& image) const
 		{
+			trace::Scope scope("Save output", m_path);
 			m_tonemapper->tonemap(image).saveLdr(m_path);
 		}
 	}
@@ -36,5 +36,10 @@ namespace glue
 
 			return geometry::Ray(m_camera_space.get_origin(), glm::normalize(m_camera_space.vectorToWorldSpace(pixel_coordinate)));
 		}
+
+		float PinholeCamera::getPixelSpreadAngle() const
+		{
+			return glm::atan(m_pixel_length.y / m_near_distance);
+		}
 	}
 }
\ No newline at end of file
@@ -34,6 +34,9 @@ namespace glue
 
 			geometry::Ray castRay(int x, int y, float offset_x = 0.5f, float offset_y = 0.5f) const;
 
+			//Angle that a pixel subtends, which is the spread of the ray cones of camera rays.
+			float getPixelSpreadAngle() const;
+
 			const glm::ivec2& get_resolution() const { return m_resolution; }
 
 		private:
@@ -1,48 +1,78 @@
 #include "real_sampler.h"
 
-#include <glm/geometric.hpp>
-
 namespace glue
 {
 	namespace core
 	{
-		UniformSampler::UniformSampler(float min, float max)
-			: m_generator(std::random_device()())
-			, m_distribution(min, max)
-		{}
+		namespace
+		{
+			constexpr std::uint64_t cPcgMultiplier = 0x5851f42d4c957f2dULL;
+		}
 
-		float UniformSampler::sample()
+		glm::vec2 RealSampler::get2D()
 		{
-			return m_distribution(m_generator);
+			auto u = sample();
+			return glm::vec2(u, sample());
 		}
 
-		TentSampler::TentSampler(float center, float radius)
-			: m_sampler(-1.0f, 1.0f)
-			, m_center(center)
-			, m_radius(radius)
-		{}
+		PcgSampler::PcgSampler(std::uint64_t sequence, std::uint64_t seed)
+		{
+			setSequence(sequence, seed);
+		}
 
-		float TentSampler::sample()
+		void PcgSampler::setSequence(std::uint64_t sequence, std::uint64_t seed)
 		{
-			auto sample = m_sampler.sample();
-			if (sample > 0.0f)
-			{
-				return (1.0f - glm::sqrt(1.0f - sample)) * m_radius + m_center;
-			}
-			else
+			m_state = 0u;
+			m_increment = (sequence << 1u) | 1u;
+			nextUint();
+			m_state += seed;
+			nextUint();
+		}
+
+		void PcgSampler::advance(std::uint64_t delta)
+		{
+			std::uint64_t curr_multiplier = cPcgMultiplier;
+			std::uint64_t curr_increment = m_increment;
+			std::uint64_t acc_multiplier = 1u;
+			std::uint64_t acc_increment = 0u;
+			for (; delta > 0; delta >>= 1)
 			{
-				return (-1.0f + glm::sqrt(1.0f + sample)) * m_radius + m_center;
+				if (delta & 1u)
+				{
+					acc_multiplier *= curr_multiplier;
+					acc_increment = acc_increment * curr_multiplier + curr_increment;
+				}
+				curr_increment = (curr_multiplier + 1u) * curr_increment;
+				curr_multiplier *= curr_multiplier;
 			}
+
+			m_state = acc_multiplier * m_state + acc_increment;
+		}
+
+		std::uint32_t PcgSampler::nextUint()
+		{
+			auto old_state = m_state;
+			m_state = old_state * cPcgMultiplier + m_increment;
+			auto xorshifted = static_cast<std::uint32_t>(((old_state >> 18u) ^ old_state) >> 27u);
+			auto rotation = static_cast<std::uint32_t>(old_state >> 59u);
+
+			return (xorshifted >> rotation) | (xorshifted << ((~rotation + 1u) & 31u));
+		}
+
+		float PcgSampler::sample()
+		{
+			//Upper 24 bits map exactly to the floats in [0, 1).
+			return (nextUint() >> 8) * 5.9604645e-08f;
 		}
 
-		GaussianSampler::GaussianSampler(float mean, float sigma)
-			: m_generator(std::random_device()())
-			, m_distribution(mean, sigma)
+		UniformSampler::UniformSampler(float min, float max)
+			: m_min(min)
+			, m_range(max - min)
 		{}
 
-		float GaussianSampler::sample()
+		float UniformSampler::sample()
 		{
-			return m_distribution(m_generator);
+			return m_min + m_range * m_generator.sample();
 		}
 	}
 }
\ No newline at end of file
@@ -1,7 +1,8 @@
 #ifndef __GLUE__CORE__REALSAMPLER__
 #define __GLUE__CORE__REALSAMPLER__
 
-#include <random>
+#include <glm/vec2.hpp>
+#include <cstdint>
 
 namespace glue
 {
@@ -13,43 +14,40 @@ namespace glue
 			virtual ~RealSampler() = default;
 
 			virtual float sample() = 0;
+			//Returns two dimensions that are meant to be used together, such as the coordinates of a point on a disk.
+			//Samplers that stratify pairs of dimensions keep both of them in the same pair.
+			virtual glm::vec2 get2D();
 		};
 
-		class UniformSampler : public RealSampler
-		{
-		public:
-			explicit UniformSampler(float min = 0.0f, float max = 1.0f);
-
-			float sample() override;
-
-		private:
-			std::mt19937 m_generator;
-			std::uniform_real_distribution<float> m_distribution;
-		};
-
-		class TentSampler : public RealSampler
+		//PCG32 generator from "PCG: A Family of Simple Fast Space-Efficient Statistically Good Algorithms for Random Number Generation" by Melissa O'Neill.
+		//Its state is 16 bytes, and any position of any of its 2^63 sequences can be reached in logarithmic time.
+		class PcgSampler : public RealSampler
 		{
 		public:
-			explicit TentSampler(float center = 0.0f, float radius = 1.0f);
+			explicit PcgSampler(std::uint64_t sequence = 0, std::uint64_t seed = 0x853c49e6748fea9bULL);
 
+			void setSequence(std::uint64_t sequence, std::uint64_t seed);
+			//Skips the next delta values of the sequence.
+			void advance(std::uint64_t delta);
+			std::uint32_t nextUint();
 			float sample() override;
 
 		private:
-			UniformSampler m_sampler;
-			float m_center;
-			float m_radius;
+			std::uint64_t m_state;
+			std::uint64_t m_increment;
 		};
 
-		class GaussianSampler : public RealSampler
+		class UniformSampler : public RealSampler
 		{
 		public:
-			explicit GaussianSampler(float mean = 0.5f, float sigma = 0.5f);
+			explicit UniformSampler(float min = 0.0f, float max = 1.0f);
 
 			float sample() override;
 
 		private:
-			std::mt19937 m_generator;
-			std::normal_distribution<float> m_distribution;
+			PcgSampler m_generator;
+			float m_min;
+			float m_range;
 		};
 	}
 }
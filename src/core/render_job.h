@@ -0,0 +1,36 @@
+#ifndef __GLUE__CORE__RENDERJOB__
+#define __GLUE__CORE__RENDERJOB__
+
+#include <string>
+
+namespace glue
+{
+	namespace core
+	{
+		//Part of a render distributed among processes. Parts are merged with "glue <scene> --merge <partials>".
+		struct RenderJob
+		{
+			//Only the tiles whose index modulo tile_part_count equals tile_part are rendered. Tiles are numbered row by row.
+			int tile_part = 0;
+			int tile_part_count = 1;
+			//Sample indices of the pixels (passes for SPPM) start from sample_begin.
+			//If sample_end is positive, it overrides the sample count of the integrator.
+			int sample_begin = 0;
+			int sample_end = 0;
+			//If it is not empty, raw accumulation is saved to this path instead of the outputs.
+			std::string partial_path;
+
+			bool isTileIncluded(int tile_index) const
+			{
+				return tile_index % tile_part_count == tile_part;
+			}
+
+			int getSampleCount(int default_sample_count) const
+			{
+				return sample_end > 0 ? sample_end - sample_begin : default_sample_count;
+			}
+		};
+	}
+}
+
+#endif
\ No newline at end of file
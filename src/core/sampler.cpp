@@ -0,0 +1,242 @@
+#include "sampler.h"
+#include "math.h"
+#include "../xml/node.h"
+
+#include <glm/common.hpp>
+#include <array>
+
+namespace glue
+{
+	namespace core
+	{
+		namespace
+		{
+			constexpr float cOneMinusEpsilon = 0.99999994f;
+
+			constexpr std::array<std::uint32_t, 32> cPrimes = {
+				2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+				59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131
+			};
+
+			inline float toUnitFloat(std::uint32_t x)
+			{
+				return glm::min(x * 2.3283064365386963e-10f, cOneMinusEpsilon);
+			}
+
+			inline std::uint32_t hashSample(const glm::ivec2& pixel, std::uint32_t dimension)
+			{
+				auto h = math::hash(static_cast<std::uint32_t>(pixel.x));
+				h = math::hash(h ^ static_cast<std::uint32_t>(pixel.y));
+				return math::hash(h ^ dimension);
+			}
+
+			//From "Practical Hash-based Owen Scrambling" by Brent Burley.
+			inline std::uint32_t laineKarrasPermutation(std::uint32_t x, std::uint32_t seed)
+			{
+				x += seed;
+				x ^= x * 0x6c50b47cu;
+				x ^= x * 0xb82f1e52u;
+				x ^= x * 0xc7afe638u;
+				x ^= x * 0x8d22f6e6u;
+				return x;
+			}
+
+			inline std::uint32_t owenScramble(std::uint32_t x, std::uint32_t seed)
+			{
+				return math::reverseBits(laineKarrasPermutation(math::reverseBits(x), seed));
+			}
+
+			//First two dimensions of the Sobol sequence as 32 bit fixed point values.
+			inline glm::uvec2 sobol2D(std::uint32_t index)
+			{
+				glm::uvec2 result(math::reverseBits(index), 0u);
+				for (std::uint32_t v = 1u << 31; index; index >>= 1, v ^= v >> 1)
+				{
+					if (index & 1u)
+					{
+						result.y ^= v;
+					}
+				}
+
+				return result;
+			}
+		}
+
+		std::unique_ptr<Sampler::Xml> Sampler::Xml::factory(const xml::Node& node)
+		{
+			auto sampler_type = node.attribute("type", true);
+
+			if (sampler_type == std::string("Independent"))
+			{
+				return std::make_unique<IndependentSampler::Xml>(node);
+			}
+			else if (sampler_type == std::string("Halton"))
+			{
+				return std::make_unique<HaltonSampler::Xml>(node);
+			}
+			else if (sampler_type == std::string("Sobol"))
+			{
+				return std::make_unique<Sobol2DSampler::Xml>(node, false);
+			}
+			else if (sampler_type == std::string("PMJ02"))
+			{
+				return std::make_unique<Sobol2DSampler::Xml>(node, true);
+			}
+			else
+			{
+				node.throwError("Unknown Sampler type.");
+			}
+
+			return nullptr;
+		}
+
+		void Sampler::startPixelSample(const glm::ivec2& pixel, std::uint32_t index, int dimension)
+		{
+			m_pixel = pixel;
+			m_index = index;
+			m_dimension = dimension;
+		}
+
+		void Sampler::startBounce(int bounce)
+		{
+			//A bounce that overran its dimensions must not share them with the next one, so the start is only moved forward.
+			auto dimension = static_cast<std::uint32_t>(cCameraSampleDimensions + bounce * cBounceSampleDimensions);
+			m_dimension = glm::max(m_dimension + (m_dimension & 1u), dimension);
+		}
+
+		float Sampler::sample()
+		{
+			return sampleDimension(m_dimension++);
+		}
+
+		glm::vec2 Sampler::get2D()
+		{
+			m_dimension += m_dimension & 1u;
+			auto u = sampleDimension(m_dimension);
+			auto v = sampleDimension(m_dimension + 1);
+			m_dimension += 2;
+
+			return glm::vec2(u, v);
+		}
+
+		//Independent
+		IndependentSampler::Xml::Xml(const xml::Node& node)
+		{}
+
+		std::unique_ptr<Sampler> IndependentSampler::Xml::create() const
+		{
+			return std::make_unique<IndependentSampler>(*this);
+		}
+
+		IndependentSampler::IndependentSampler(const IndependentSampler::Xml& xml)
+			: m_generator_dimension(0)
+		{}
+
+		void IndependentSampler::startPixelSample(const glm::ivec2& pixel, std::uint32_t index, int dimension)
+		{
+			Sampler::startPixelSample(pixel, index, dimension);
+
+			auto sequence = (static_cast<std::uint64_t>(math::hash(static_cast<std::uint32_t>(pixel.x))) << 32u) |
+				math::hash(static_cast<std::uint32_t>(pixel.y));
+			m_generator.setSequence(sequence, math::hash(index));
+			m_generator_dimension = 0;
+		}
+
+		std::unique_ptr<Sampler> IndependentSampler::clone() const
+		{
+			return std::make_unique<IndependentSampler>(*this);
+		}
+
+		float IndependentSampler::sampleDimension(std::uint32_t dimension)
+		{
+			//Dimensions skipped by startBounce() or get2D() are skipped in the sequence as well, so that every dimension has a fixed value.
+			m_generator.advance(dimension - m_generator_dimension);
+			m_generator_dimension = dimension + 1;
+			return m_generator.sample();
+		}
+
+		//Halton
+		HaltonSampler::Xml::Xml(const xml::Node& node)
+		{}
+
+		std::unique_ptr<Sampler> HaltonSampler::Xml::create() const
+		{
+			return std::make_unique<HaltonSampler>(*this);
+		}
+
+		HaltonSampler::HaltonSampler(const HaltonSampler::Xml& xml)
+		{}
+
+		std::unique_ptr<Sampler> HaltonSampler::clone() const
+		{
+			return std::make_unique<HaltonSampler>(*this);
+		}
+
+		float HaltonSampler::sampleDimension(std::uint32_t dimension)
+		{
+			auto seed = hashSample(m_pixel, dimension);
+			//Dimensions beyond the prime table fall back to hashed random values.
+			if (dimension >= cPrimes.size())
+			{
+				return toUnitFloat(math::hash(seed ^ m_index));
+			}
+
+			auto base = cPrimes[dimension];
+			auto inv_base = 1.0f / base;
+			auto inv_base_n = 1.0f;
+			auto radical_inverse = 0.0f;
+			for (auto index = m_index; index; index /= base)
+			{
+				inv_base_n *= inv_base;
+				radical_inverse += (index % base) * inv_base_n;
+			}
+
+			auto value = radical_inverse + toUnitFloat(seed);
+			return glm::min(value < 1.0f ? value : value - 1.0f, cOneMinusEpsilon);
+		}
+
+		//Sobol and PMJ02
+		Sobol2DSampler::Xml::Xml(const xml::Node& node, bool p_owen_scrambling)
+			: owen_scrambling(p_owen_scrambling)
+		{}
+
+		std::unique_ptr<Sampler> Sobol2DSampler::Xml::create() const
+		{
+			return std::make_unique<Sobol2DSampler>(*this);
+		}
+
+		Sobol2DSampler::Sobol2DSampler(const Sobol2DSampler::Xml& xml)
+			: m_owen_scrambling(xml.owen_scrambling)
+		{}
+
+		std::unique_ptr<Sampler> Sobol2DSampler::clone() const
+		{
+			return std::make_unique<Sobol2DSampler>(*this);
+		}
+
+		float Sobol2DSampler::sampleDimension(std::uint32_t dimension)
+		{
+			//Both dimensions of a pair are generated at once.
+			if (dimension & 1u)
+			{
+				return m_pair.y;
+			}
+
+			auto seed = hashSample(m_pixel, dimension >> 1);
+			auto point = sobol2D(owenScramble(m_index, seed));
+			if (m_owen_scrambling)
+			{
+				point.x = owenScramble(point.x, math::hash(seed ^ 0x5bd1e995u));
+				point.y = owenScramble(point.y, math::hash(seed ^ 0x1b873593u));
+			}
+			else
+			{
+				point.x ^= math::hash(seed ^ 0x5bd1e995u);
+				point.y ^= math::hash(seed ^ 0x1b873593u);
+			}
+			m_pair = glm::vec2(toUnitFloat(point.x), toUnitFloat(point.y));
+
+			return m_pair.x;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#ifndef __GLUE__CORE__SAMPLER__
+#define __GLUE__CORE__SAMPLER__
+
+#include "forward_decl.h"
+#include "real_sampler.h"
+
+#include <glm/vec2.hpp>
+#include <cstdint>
+#include <memory>
+
+namespace glue
+{
+	namespace core
+	{
+		//Amount of dimensions consumed by the filter offset of a camera ray.
+		constexpr int cCameraSampleDimensions = 2;
+		//Amount of dimensions reserved for each bounce of a path. Bounces that consume more push the next ones further.
+		constexpr int cBounceSampleDimensions = 16;
+
+		//Samplers hand out the dimensions of a pixel sample one by one through sample(), or two at a time through get2D().
+		//startPixelSample() has to be called before the first dimension of every sample.
+		//The starting dimension has to be even since some samplers generate the dimensions in pairs.
+		//Paths consume a varying number of dimensions per bounce, so every bounce starts at a fixed dimension through startBounce().
+		//Otherwise the same decision of different samples would fall into different dimensions and lose the stratification.
+		class Sampler : public RealSampler
+		{
+		public:
+			//Xml structure of the class.
+			struct Xml
+			{
+				virtual ~Xml() = default;
+				virtual std::unique_ptr<Sampler> create() const = 0;
+				static std::unique_ptr<Sampler::Xml> factory(const xml::Node& node);
+			};
+
+		public:
+			virtual ~Sampler() = default;
+
+			virtual void startPixelSample(const glm::ivec2& pixel, std::uint32_t index, int dimension = 0);
+			//Skips to the first dimension of the bounce. Bounce 0 starts right after the camera sample dimensions.
+			void startBounce(int bounce);
+			float sample() override;
+			//Starts at an even dimension so that both values come from the same pair.
+			glm::vec2 get2D() override;
+			virtual std::unique_ptr<Sampler> clone() const = 0;
+
+		protected:
+			glm::ivec2 m_pixel;
+			std::uint32_t m_index;
+			std::uint32_t m_dimension;
+
+		protected:
+			virtual float sampleDimension(std::uint32_t dimension) = 0;
+		};
+
+		//Every sample is a separate PCG sequence seeded by the pixel and the sample index,
+		//so renders are reproducible regardless of the thread count and the order of the tiles.
+		class IndependentSampler : public Sampler
+		{
+		public:
+			//Xml structure of the class.
+			struct Xml : public Sampler::Xml
+			{
+				Xml() = default;
+				explicit Xml(const xml::Node& node);
+				std::unique_ptr<Sampler> create() const override;
+			};
+
+		public:
+			explicit IndependentSampler(const IndependentSampler::Xml& xml);
+
+			void startPixelSample(const glm::ivec2& pixel, std::uint32_t index, int dimension = 0) override;
+			std::unique_ptr<Sampler> clone() const override;
+
+		private:
+			PcgSampler m_generator;
+			std::uint32_t m_generator_dimension; //Dimension of the next value of the generator.
+
+		private:
+			float sampleDimension(std::uint32_t dimension) override;
+		};
+
+		//Base-b radical inverses with a toroidal shift per pixel and dimension.
+		class HaltonSampler : public Sampler
+		{
+		public:
+			//Xml structure of the class.
+			struct Xml : public Sampler::Xml
+			{
+				explicit Xml(const xml::Node& node);
+				std::unique_ptr<Sampler> create() const override;
+			};
+
+		public:
+			explicit HaltonSampler(const HaltonSampler::Xml& xml);
+
+			std::unique_ptr<Sampler> clone() const override;
+
+		private:
+			float sampleDimension(std::uint32_t dimension) override;
+		};
+
+		//Pairs of dimensions are drawn from the first two Sobol dimensions, that is, a (0,2)-sequence.
+		//The sample order is shuffled per pixel and pair so that the pairs are not correlated with each other.
+		//Sobol uses random digit (xor) scrambling while PMJ02 uses Owen scrambling, which keeps
+		//the progressive multi-jittered stratification of every prefix of the sequence.
+		class Sobol2DSampler : public Sampler
+		{
+		public:
+			//Xml structure of the class.
+			struct Xml : public Sampler::Xml
+			{
+				bool owen_scrambling;
+
+				Xml(const xml::Node& node, bool p_owen_scrambling);
+				std::unique_ptr<Sampler> create() const override;
+			};
+
+		public:
+			explicit Sobol2DSampler(const Sobol2DSampler::Xml& xml);
+
+			std::unique_ptr<Sampler> clone() const override;
+
+		private:
+			glm::vec2 m_pair;
+			bool m_owen_scrambling;
+
+		private:
+			float sampleDimension(std::uint32_t dimension) override;
+		};
+	}
+}
+
+#endif
\ No newline at end of file
@@ -1,21 +1,67 @@
 #include "scene.h"
 #include "real_sampler.h"
 #include "timer.h"
+#include "binary_io.h"
+#include "memory.h"
+#include "stats.h"
+#include "thread_pool.h"
 #include "../geometry/sphere.h"
 #include "../material/lambertian.h"
 #include "../texture/constant_texture.h"
 #include "../xml/node.h"
+#include "../xml/parser.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
 
 namespace glue
 {
 	namespace core
 	{
+		namespace
+		{
+			constexpr char cCheckpointMagic[8] = { 'G', 'L', 'U', 'E', 'C', 'K', 'P', 'T' };
+			//Version 2 stores the pixels row by row.
+			constexpr std::uint32_t cCheckpointVersion = 2;
+			constexpr char cPartialMagic[8] = { 'G', 'L', 'U', 'E', 'P', 'A', 'R', 'T' };
+			constexpr std::uint32_t cPartialVersion = 2;
+		}
+
+		namespace
+		{
+			thread_local int tReplica = 0; //Replica intersected by the calling thread.
+		}
+
+		std::atomic<bool> Scene::gStopRequested(false);
+
 		Scene::Xml::Xml(const xml::Node& node)
 		{
 			node.parseChildText("BackgroundRadiance", &background_radiance.x, 0.0f, &background_radiance.y, 0.0f, &background_radiance.z, 0.0f);
 			node.parseChildText("SecondaryRayEpsilon", &secondary_ray_epsilon, 1e-4f);
+			node.parseChildText("TimeLimit", &time_limit, 0.0f);
+			node.parseChildText("OutputInterval", &output_interval, 0.0f);
+			node.parseChildText("CheckpointPath", &checkpoint_path, std::string());
+			node.parseChildText("CheckpointInterval", &checkpoint_interval, 0.0f);
+			node.parseChildText("ThreadCount", &thread_count, 0);
+			std::string order;
+			node.parseChildText("TileOrder", &order, std::string("Hilbert"));
+			tile_order = TileScheduler::parseTileOrder(order);
+			std::string numa_policy_name;
+			node.parseChildText("NumaPolicy", &numa_policy_name, std::string("None"));
+			numa_policy = NumaTopology::parsePolicy(numa_policy_name);
+			node.parseChildText("CostMapPath", &cost_map_path, std::string());
 			integrator = integrator::Integrator::Xml::factory(node.child("Integrator", true));
 			for (auto output = node.child("Output"); output; output = output.next())
 			{
@@ -34,7 +80,18 @@ namespace glue
 
 		Scene::Scene(const Scene::Xml& xml)
 			: environment_light(nullptr)
+			, thread_count(xml.thread_count > 0 ? xml.thread_count : ThreadPool::getDefaultWorkerCount())
+			, tile_order(xml.tile_order)
+			, numa_policy(xml.numa_policy)
+			, m_time_limit(xml.time_limit)
+			, m_output_interval(xml.output_interval)
+			, m_checkpoint_path(xml.checkpoint_path)
+			, m_checkpoint_interval(xml.checkpoint_interval)
+			, m_cost_map_path(xml.cost_map_path)
 		{
+			//Workers are pinned once when they are started, and stay on their NUMA nodes for the whole render.
+			ThreadPool::configure(thread_count, [this](int worker) { bindWorker(worker); });
+
 			background_radiance = xml.background_radiance;
 			secondary_ray_epsilon = xml.secondary_ray_epsilon;
 			m_integrator = xml.integrator->create();
@@ -44,9 +101,108 @@ namespace glue
 			}
 			camera = std::make_unique<PinholeCamera>(*xml.camera);
 			m_image = std::make_unique<Image>(camera->get_resolution().x, camera->get_resolution().y);
-			for (const auto& object_xml : xml.objects)
+			if (!m_cost_map_path.empty())
+			{
+				cost_map = std::make_unique<CostMap>(camera->get_resolution());
+				memory::set("Framebuffer", "Cost map", cost_map->getMemoryUsage());
+			}
+			for (const auto& light_xml : xml.lights)
+			{
+				auto light = light_xml->create();
+				auto object = light->getObject();
+				if (object)
+				{
+					object_to_light[object.get()] = light.get();
+					m_light_objects.push_back(object);
+				}
+				lights.push_back(std::move(light));
+
+				if (light_xml->attributes["type"] == "EnvironmentLight")
+				{
+					if (environment_light)
+					{
+						throw std::runtime_error("Error: There can be at most one EnvironmentLight");
+					}
+					environment_light = std::static_pointer_cast<light::EnvironmentLight>(lights.back());
+				}
+			}
+
+			stats::ScopedPhase phase("Objects and BVH");
+			//Memory is placed on the node of the thread that first touches it, so every replica is created by a thread pinned to its node.
+			//Replicas are created at the same time while each of them is created serially, since the pool spans all of the nodes.
+			if (numa_policy == NumaPolicy::REPLICATE)
+			{
+				int numof_nodes = m_numa.get_nodes().size();
+				std::vector<std::thread> threads;
+				std::vector<std::exception_ptr> errors(numof_nodes);
+				for (int i = 0; i < numof_nodes; ++i)
+				{
+					m_bvhs.push_back(std::make_unique<geometry::BVH<std::shared_ptr<geometry::Object>>>());
+				}
+				for (int i = 0; i < numof_nodes; ++i)
+				{
+					threads.emplace_back([this, &xml, &errors, i]()
+					{
+						try
+						{
+							ThreadPool::SerialScope serial;
+							m_numa.pinCurrentThreadToNode(i);
+							xml::Parser::setReplica(i);
+							createObjects(xml, *m_bvhs[i]);
+						}
+						catch (...)
+						{
+							errors[i] = std::current_exception();
+						}
+					});
+				}
+				for (auto& thread : threads)
+				{
+					thread.join();
+				}
+				for (const auto& error : errors)
+				{
+					if (error)
+					{
+						std::rethrow_exception(error);
+					}
+				}
+			}
+			else
+			{
+				bool interleaved = numa_policy == NumaPolicy::INTERLEAVE && m_numa.setInterleaved(true);
+				m_bvhs.push_back(std::make_unique<geometry::BVH<std::shared_ptr<geometry::Object>>>());
+				if (interleaved)
+				{
+					//The memory policy only applies to the calling thread, so the objects are loaded on it alone.
+					ThreadPool::SerialScope serial;
+					createObjects(xml, *m_bvhs[0]);
+					m_numa.setInterleaved(false);
+				}
+				else
+				{
+					createObjects(xml, *m_bvhs[0]);
+				}
+			}
+
+			for (std::size_t i = 0; i < m_bvhs.size(); ++i)
 			{
-				auto object = object_xml->create();
+				auto name = m_bvhs.size() > 1 ? "Scene (replica " + std::to_string(i) + ")" : std::string("Scene");
+				memory::set("BVH nodes", name, m_bvhs[i]->getNodeMemoryUsage());
+				memory::set("BVH primitives", name, m_bvhs[i]->getPrimitiveMemoryUsage());
+			}
+			memory::set("Framebuffer", "Image", m_image->getMemoryUsage());
+		}
+
+		void Scene::createObjects(const Scene::Xml& xml, geometry::BVH<std::shared_ptr<geometry::Object>>& bvh) const
+		{
+			//Objects are created in parallel, then added in the order of the scene file.
+			int numof_objects = xml.objects.size();
+			std::vector<std::vector<std::shared_ptr<geometry::Object>>> objects(numof_objects);
+			ThreadPool::get().parallelFor(0, numof_objects, 1, [&xml, &objects](int o, int worker)
+			{
+				const auto& object_xml = xml.objects[o];
+				std::shared_ptr<geometry::Object> object = object_xml->create();
 
 				//Add debug spheres
 				if (object_xml->attributes.find("displayRandomSamples") != object_xml->attributes.end())
@@ -61,51 +217,43 @@ namespace glue
 						auto bsdf_material = std::make_unique<material::Lambertian::Xml>(std::make_unique<texture::ConstantTexture::Xml>(glm::vec3(0.8f, 0.0f, 0.0f)));
 						geometry::Sphere::Xml debug_sphere_xml(radius, center, transformation, std::move(bsdf_material));
 
-						m_bvh.addObject(debug_sphere_xml.create());
+						objects[o].push_back(debug_sphere_xml.create());
 					}
 				}
 
-				m_bvh.addObject(std::move(object));
-			}
-			for (const auto& light_xml : xml.lights)
+				objects[o].push_back(std::move(object));
+			});
+			for (auto& object_group : objects)
 			{
-				auto light = light_xml->create();
-				auto object = light->getObject();
-				if (object)
-				{
-					object_to_light[object.get()] = light.get();
-					m_bvh.addObject(object);
-				}
-				lights.push_back(std::move(light));
-
-				if (light_xml->attributes["type"] == "EnvironmentLight")
+				for (auto& object : object_group)
 				{
-					if (environment_light)
-					{
-						throw std::runtime_error("Error: There can be at most one EnvironmentLight");
-					}
-					environment_light = lights.back();
+					bvh.addObject(std::move(object));
 				}
 			}
+			for (const auto& object : m_light_objects)
+			{
+				bvh.addObject(object);
+			}
 
-			if (m_bvh.get_objects().size() < 1024)
+			if (bvh.get_objects().size() < 1024)
 			{
-				m_bvh.buildWithMedianSplit();
+				bvh.buildWithMedianSplit();
 			}
 			else
 			{
-				m_bvh.buildWithSAHSplit();
+				bvh.buildWithSAHSplit();
 			}
 		}
 
 		geometry::BBox Scene::getBBox() const
 		{
-			return m_bvh.get_root()->bbox;
+			return getBVH().get_root()->bbox;
 		}
 
 		bool Scene::intersect(const geometry::Ray& ray, geometry::Intersection& intersection, float max_distance) const
 		{
-			auto result = m_bvh.intersect(ray, intersection, max_distance);
+			auto result = getBVH().intersect(ray, intersection, max_distance);
+			stats::add(stats::Counter::CLOSEST_HIT_RAYS);
 
 			if (intersection.object)
 			{
@@ -117,32 +265,314 @@ namespace glue
 
 		bool Scene::intersectShadowRay(const geometry::Ray& ray, float max_distance) const
 		{
-			return m_bvh.intersectShadowRay(ray, max_distance);
+			stats::add(stats::Counter::SHADOW_RAYS);
+			return getBVH().intersectShadowRay(ray, max_distance);
+		}
+
+		void Scene::bindWorker(int worker) const
+		{
+			if (numa_policy != NumaPolicy::NONE)
+			{
+				auto node = m_numa.getNodeOfWorker(worker);
+				m_numa.pinCurrentThreadToNode(node);
+				tReplica = numa_policy == NumaPolicy::REPLICATE ? node : 0;
+			}
+		}
+
+		std::vector<int> Scene::getWorkerNodes() const
+		{
+			std::vector<int> worker_nodes;
+			if (numa_policy != NumaPolicy::NONE)
+			{
+				for (int i = 0; i < thread_count; ++i)
+				{
+					worker_nodes.push_back(m_numa.getNodeOfWorker(i));
+				}
+			}
+
+			return worker_nodes;
+		}
+
+		const geometry::BVH<std::shared_ptr<geometry::Object>>& Scene::getBVH() const
+		{
+			return *m_bvhs[tReplica];
 		}
 
 		void Scene::render()
 		{
-			Timer timer;
-			timer.start();
-			m_integrator->integrate(*this, *m_image);
-			std::cout << "Render time: " << timer.getTime() << std::endl;
+			m_render_timer.start();
+			m_checkpoint_timer.start();
+
+			//Intermediate outputs are saved by a separate thread so that the workers are never stalled.
+			std::mutex mutex;
+			std::condition_variable condition;
+			bool render_done = false;
+			std::thread output_thread;
+			if (m_output_interval > 0.0f)
+			{
+				output_thread = std::thread([this, &mutex, &condition, &render_done]()
+				{
+					//Outputs are encoded on this thread alone while the workers are busy with the render.
+					ThreadPool::SerialScope serial;
+					std::unique_lock<std::mutex> lock(mutex);
+					while (!condition.wait_for(lock, std::chrono::duration<float>(m_output_interval), [&render_done]() { return render_done; }))
+					{
+						auto time = m_render_timer.getTime();
+						//The integrator may be writing to m_image, so the progress is only taken from what it has published.
+						Image progress(m_image->get_width(), m_image->get_height());
+						getProgress(progress);
+						saveOutputs(progress);
+						std::cout << "Intermediate output saved at: " << m_render_timer.getTime() << std::endl;
+						if (progress_callback)
+						{
+							progress_callback(progress, time);
+						}
+					}
+				});
+			}
+
+			{
+				stats::ScopedPhase phase("Render");
+				m_integrator->integrate(*this, *m_image);
+			}
+
+			if (output_thread.joinable())
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					render_done = true;
+				}
+				condition.notify_one();
+				output_thread.join();
+			}
+			std::cout << "Render time: " << m_render_timer.getTime() << std::endl;
+			if (progress_callback)
+			{
+				progress_callback(*m_image, m_render_timer.getTime());
+			}
+
+			stats::ScopedPhase phase("Output");
+			if (job.partial_path.empty())
+			{
+				saveOutputs(*m_image);
+			}
+			else
+			{
+				savePartial();
+			}
+
+			if (cost_map)
+			{
+				cost_map->save(m_cost_map_path);
+			}
+		}
+
+		void Scene::getProgress(Image& image) const
+		{
+			m_integrator->getProgress(*this, image);
+		}
+
+		bool Scene::hasTimeLimit() const
+		{
+			return m_time_limit > 0.0f;
+		}
+
+		double Scene::getRemainingTime() const
+		{
+			if (!hasTimeLimit())
+			{
+				return std::numeric_limits<double>::infinity();
+			}
+
+			return m_time_limit - m_render_timer.getTime();
+		}
+
+		bool Scene::isStopRequested() const
+		{
+			return gStopRequested.load(std::memory_order_relaxed) || getRemainingTime() <= 0.0;
+		}
+
+		bool Scene::isCheckpointDue() const
+		{
+			if (m_checkpoint_path.empty())
+			{
+				return false;
+			}
+
+			return gStopRequested.load(std::memory_order_relaxed) ||
+				(m_checkpoint_interval > 0.0f && m_checkpoint_timer.getTime() >= m_checkpoint_interval);
+		}
+
+		void Scene::saveCheckpoint() const
+		{
+			//Written to a temporary file first so that a kill during the write does not corrupt the last checkpoint.
+			auto temp_path = m_checkpoint_path + ".tmp";
+			{
+				std::ofstream stream(temp_path, std::ios::binary);
+				if (!stream)
+				{
+					throw std::runtime_error("Error: Cannot open checkpoint file " + temp_path);
+				}
+
+				stream.write(cCheckpointMagic, sizeof(cCheckpointMagic));
+				binary::write(stream, cCheckpointVersion);
+				binary::write(stream, camera->get_resolution());
+				m_integrator->saveCheckpoint(stream, *m_image);
+
+				if (!stream)
+				{
+					throw std::runtime_error("Error: Cannot write checkpoint file " + temp_path);
+				}
+			}
+
+			//The old checkpoint is replaced in a single step, so one of the two is always on disk.
+#ifdef _WIN32
+			if (!MoveFileExA(temp_path.c_str(), m_checkpoint_path.c_str(), MOVEFILE_REPLACE_EXISTING))
+#else
+			if (std::rename(temp_path.c_str(), m_checkpoint_path.c_str()) != 0)
+#endif
+			{
+				throw std::runtime_error("Error: Cannot rename checkpoint file " + temp_path);
+			}
+
+			m_checkpoint_timer.start();
+			std::cout << "Checkpoint saved at: " << m_render_timer.getTime() << std::endl;
+		}
+
+		void Scene::loadCheckpoint(const std::string& path)
+		{
+			std::ifstream stream(path, std::ios::binary);
+			if (!stream)
+			{
+				throw std::runtime_error("Error: Cannot open checkpoint file " + path);
+			}
+
+			char magic[sizeof(cCheckpointMagic)];
+			std::uint32_t version;
+			glm::ivec2 resolution;
+			if (!stream.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), cCheckpointMagic))
+			{
+				throw std::runtime_error("Error: " + path + " is not a checkpoint file");
+			}
+			binary::read(stream, version);
+			if (version != cCheckpointVersion)
+			{
+				throw std::runtime_error("Error: Unsupported checkpoint version in " + path);
+			}
+			binary::read(stream, resolution);
+			if (resolution != camera->get_resolution())
+			{
+				throw std::runtime_error("Error: Resolution of the checkpoint does not match the scene");
+			}
+
+			m_integrator->loadCheckpoint(stream, *m_image);
+		}
+
+		void Scene::savePartial() const
+		{
+			std::vector<glm::vec3> weighted_sums;
+			std::vector<float> weights;
+			m_integrator->getPartial(*m_image, weighted_sums, weights);
 
-			int size = m_outputs.size();
-			int i;
-			#pragma omp parallel for
-			for (i = 0; i < size; ++i)
+			std::ofstream stream(job.partial_path, std::ios::binary);
+			if (!stream)
+			{
+				throw std::runtime_error("Error: Cannot open partial file " + job.partial_path);
+			}
+			stream.write(cPartialMagic, sizeof(cPartialMagic));
+			binary::write(stream, cPartialVersion);
+			binary::write(stream, camera->get_resolution());
+			binary::writeVector(stream, weighted_sums);
+			binary::writeVector(stream, weights);
+			if (!stream)
 			{
-				m_outputs[i]->save(*m_image);
+				throw std::runtime_error("Error: Cannot write partial file " + job.partial_path);
 			}
 		}
 
-		glm::vec3 Scene::getBackgroundRadiance(const glm::vec3& direction, bool light_explicitly_sampled) const
+		void Scene::mergePartials(const Scene::Xml& xml, const std::vector<std::string>& paths)
+		{
+			auto resolution = xml.camera->resolution;
+			auto numof_pixels = static_cast<std::size_t>(resolution.x * resolution.y);
+			std::vector<glm::vec3> total_weighted_sums(numof_pixels, glm::vec3(0.0f));
+			std::vector<float> total_weights(numof_pixels, 0.0f);
+
+			for (const auto& path : paths)
+			{
+				std::ifstream stream(path, std::ios::binary);
+				if (!stream)
+				{
+					throw std::runtime_error("Error: Cannot open partial file " + path);
+				}
+
+				char magic[sizeof(cPartialMagic)];
+				std::uint32_t version;
+				glm::ivec2 partial_resolution;
+				if (!stream.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), cPartialMagic))
+				{
+					throw std::runtime_error("Error: " + path + " is not a partial file");
+				}
+				binary::read(stream, version);
+				binary::read(stream, partial_resolution);
+				if (version != cPartialVersion || partial_resolution != resolution)
+				{
+					throw std::runtime_error("Error: " + path + " does not match the scene");
+				}
+
+				std::vector<glm::vec3> weighted_sums;
+				std::vector<float> weights;
+				binary::readVector(stream, weighted_sums);
+				binary::readVector(stream, weights);
+				if (weighted_sums.size() != numof_pixels || weights.size() != numof_pixels)
+				{
+					throw std::runtime_error("Error: " + path + " is corrupted");
+				}
+
+				for (std::size_t i = 0; i < numof_pixels; ++i)
+				{
+					total_weighted_sums[i] += weighted_sums[i];
+					total_weights[i] += weights[i];
+				}
+			}
+
+			Image image(resolution.x, resolution.y);
+			std::vector<glm::vec3> row(resolution.x);
+			for (int y = 0; y < resolution.y; ++y)
+			{
+				for (int x = 0; x < resolution.x; ++x)
+				{
+					auto index = y * resolution.x + x;
+					row[x] = total_weights[index] > 0.0f ? total_weighted_sums[index] / total_weights[index] : glm::vec3(0.0f);
+				}
+				image.setRow(y, row);
+			}
+
+			for (const auto& output_xml : xml.outputs)
+			{
+				output_xml->create()->save(image);
+			}
+		}
+
+		void Scene::requestStop()
+		{
+			gStopRequested.store(true, std::memory_order_relaxed);
+		}
+
+		void Scene::saveOutputs(const Image& image) const
+		{
+			ThreadPool::get().parallelFor(0, m_outputs.size(), 1, [this, &image](int i, int worker)
+			{
+				m_outputs[i]->save(image);
+			});
+		}
+
+		glm::vec3 Scene::getBackgroundRadiance(const glm::vec3& direction, bool light_explicitly_sampled, float spread_angle) const
 		{
 			if (environment_light)
 			{
 				if (!light_explicitly_sampled)
 				{
-					return environment_light->getLe(direction, glm::vec3(0.0f), 0.0f);
+					return spread_angle > 0.0f ? environment_light->getFilteredLe(direction, spread_angle) : environment_light->getLe(direction, glm::vec3(0.0f), 0.0f);
 				}
 				else
 				{
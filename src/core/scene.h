@@ -7,8 +7,17 @@
 #include "../geometry/object.h"
 #include "../geometry/bvh.h"
 #include "../light/light.h"
+#include "../light/environment_light.h"
 #include "../integrator/integrator.h"
+#include "timer.h"
+#include "render_job.h"
+#include "tile_scheduler.h"
+#include "numa.h"
+#include "cost_map.h"
 
+#include <atomic>
+#include <functional>
+#include <string>
 #include <vector>
 #include <memory>
 #include <unordered_map>
@@ -26,6 +35,14 @@ namespace glue
 			{
 				glm::vec3 background_radiance;
 				float secondary_ray_epsilon;
+				float time_limit; //In seconds. If it is not positive, integrators render their sample counts.
+				float output_interval; //In seconds. If it is not positive, outputs are only saved at the end.
+				std::string checkpoint_path; //If it is empty, checkpoints are disabled.
+				float checkpoint_interval; //In seconds. If it is not positive, a checkpoint is only written when the render is interrupted.
+				int thread_count; //If it is not positive, all hardware threads are used.
+				TileOrder tile_order;
+				NumaPolicy numa_policy;
+				std::string cost_map_path; //If it is not empty, per-pixel render costs are saved with this prefix.
 				std::unique_ptr<integrator::Integrator::Xml> integrator;
 				std::vector<std::unique_ptr<Output::Xml>> outputs;
 				std::unique_ptr<PinholeCamera::Xml> camera;
@@ -38,10 +55,17 @@ namespace glue
 		public:
 			std::unique_ptr<PinholeCamera> camera;
 			std::vector<std::shared_ptr<light::Light>> lights;
-			std::shared_ptr<light::Light> environment_light;
+			std::shared_ptr<light::EnvironmentLight> environment_light;
 			std::unordered_map<const geometry::Object*, const light::Light*> object_to_light;
 			glm::vec3 background_radiance;
 			float secondary_ray_epsilon;
+			RenderJob job;
+			int thread_count;
+			TileOrder tile_order;
+			NumaPolicy numa_policy;
+			std::unique_ptr<CostMap> cost_map; //Null unless CostMapPath is given.
+			//Called with every intermediate image on the thread that saves them, then with the final image. Time is in seconds since the render started.
+			std::function<void(const Image& image, double time)> progress_callback;
 
 		public:
 			explicit Scene(const Scene::Xml& xml);
@@ -49,14 +73,53 @@ namespace glue
 			geometry::BBox getBBox() const;
 			bool intersect(const geometry::Ray& ray, geometry::Intersection& intersection, float max_distance) const;
 			bool intersectShadowRay(const geometry::Ray& ray, float max_distance) const;
+			//BVH of the objects that the calling thread intersects, which is the replica of its NUMA node if the scene is replicated.
+			const geometry::BVH<std::shared_ptr<geometry::Object>>& getBVH() const;
 			void render();
-			glm::vec3 getBackgroundRadiance(const glm::vec3& direction, bool light_explicitly_sampled) const;
+			//Writes the image as of the last patch or pass that the integrator has published. It may be called while another thread renders.
+			void getProgress(Image& image) const;
+			//NUMA node of every worker for the tile scheduler. Empty if the workers are not pinned.
+			std::vector<int> getWorkerNodes() const;
+			//The environment is filtered over the spread angle of the ray cone, so that distant texels are not aliased.
+			glm::vec3 getBackgroundRadiance(const glm::vec3& direction, bool light_explicitly_sampled, float spread_angle = 0.0f) const;
+			//Integrators poll these between samples to stop at the time limit or on an interrupt.
+			bool hasTimeLimit() const;
+			double getRemainingTime() const;
+			bool isStopRequested() const;
+			bool isCheckpointDue() const;
+			void saveCheckpoint() const;
+			void loadCheckpoint(const std::string& path);
+
+			//Merges the partial results of a distributed render and saves the outputs of the scene.
+			static void mergePartials(const Scene::Xml& xml, const std::vector<std::string>& paths);
+
+			//Safe to call from signal handlers.
+			static void requestStop();
 
 		private:
-			geometry::BVH<std::shared_ptr<geometry::Object>> m_bvh;
+			std::vector<std::unique_ptr<geometry::BVH<std::shared_ptr<geometry::Object>>>> m_bvhs; //One per NUMA node if the scene is replicated.
+			std::vector<std::shared_ptr<geometry::Object>> m_light_objects; //Shared by the replicas since lights refer to them.
+			NumaTopology m_numa;
 			std::unique_ptr<integrator::Integrator> m_integrator;
 			std::unique_ptr<Image> m_image;
 			std::vector<std::unique_ptr<Output>> m_outputs;
+			Timer m_render_timer;
+			float m_time_limit;
+			float m_output_interval;
+			mutable Timer m_checkpoint_timer;
+			std::string m_checkpoint_path;
+			float m_checkpoint_interval;
+			std::string m_cost_map_path;
+
+			static std::atomic<bool> gStopRequested;
+
+		private:
+			//Called by every worker of the thread pool when it starts. Depending on the NUMA policy, it pins the worker
+			//to its node and makes it intersect the replica of that node.
+			void bindWorker(int worker) const;
+			void createObjects(const Scene::Xml& xml, geometry::BVH<std::shared_ptr<geometry::Object>>& bvh) const;
+			void saveOutputs(const Image& image) const;
+			void savePartial() const;
 		};
 	}
 }
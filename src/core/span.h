@@ -0,0 +1,47 @@
+#ifndef __GLUE__CORE__SPAN__
+#define __GLUE__CORE__SPAN__
+
+#include <cstddef>
+#include <vector>
+
+namespace glue
+{
+	namespace core
+	{
+		//Non-owning view of contiguous values, until the renderer moves to C++20.
+		template<typename T>
+		class Span
+		{
+		public:
+			Span() = default;
+			Span(T* data, std::size_t size)
+				: m_data(data)
+				, m_size(size)
+			{}
+			template<typename U>
+			Span(std::vector<U>& values)
+				: m_data(values.data())
+				, m_size(values.size())
+			{}
+			template<typename U>
+			Span(const std::vector<U>& values)
+				: m_data(values.data())
+				, m_size(values.size())
+			{}
+
+			T& operator[](std::size_t index) const { return m_data[index]; }
+			T* begin() const { return m_data; }
+			T* end() const { return m_data + m_size; }
+			Span subspan(std::size_t offset, std::size_t count) const { return Span(m_data + offset, count); }
+
+			T* data() const { return m_data; }
+			std::size_t size() const { return m_size; }
+
+		private:
+			T* m_data = nullptr;
+			std::size_t m_size = 0;
+		};
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "stats.h"
+#include "memory.h"
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace glue
+{
+	namespace core
+	{
+		namespace stats
+		{
+			namespace
+			{
+				std::mutex gMutex;
+				std::vector<std::unique_ptr<ThreadCounters>> gThreadCounters;
+				std::map<std::string, double> gPhaseTimes;
+
+				const char* cCounterNames[] = {
+					"camera", "bounce", "photon", "shadow", "closest_hit", "bvh_nodes_visited", "primitives_tested", "russian_roulette_terminations"
+				};
+				static_assert(sizeof(cCounterNames) / sizeof(cCounterNames[0]) == static_cast<int>(Counter::SIZE), "Every counter needs a name.");
+
+				inline double divide(double a, double b)
+				{
+					return b > 0.0 ? a / b : 0.0;
+				}
+			}
+
+			ThreadCounters* registerThread()
+			{
+				std::lock_guard<std::mutex> lock(gMutex);
+				gThreadCounters.push_back(std::make_unique<ThreadCounters>());
+				return gThreadCounters.back().get();
+			}
+
+			void addPhaseTime(const std::string& phase, double seconds)
+			{
+				std::lock_guard<std::mutex> lock(gMutex);
+				gPhaseTimes[phase] += seconds;
+			}
+
+			double getPhaseTime(const std::string& phase)
+			{
+				std::lock_guard<std::mutex> lock(gMutex);
+				auto iter = gPhaseTimes.find(phase);
+				return iter != gPhaseTimes.end() ? iter->second : 0.0;
+			}
+
+			std::uint64_t getTotal(Counter counter)
+			{
+				std::lock_guard<std::mutex> lock(gMutex);
+				std::uint64_t total = 0;
+				for (const auto& counters : gThreadCounters)
+				{
+					total += counters->counters[static_cast<int>(counter)];
+				}
+
+				return total;
+			}
+
+			void reset()
+			{
+				std::lock_guard<std::mutex> lock(gMutex);
+				for (auto& counters : gThreadCounters)
+				{
+					*counters = ThreadCounters();
+				}
+				gPhaseTimes.clear();
+			}
+
+			ScopedPhase::ScopedPhase(const char* phase)
+				: m_phase(phase)
+				, m_trace_scope(phase)
+			{}
+
+			ScopedPhase::~ScopedPhase()
+			{
+				addPhaseTime(m_phase, m_timer.getTime());
+			}
+
+			void writeReport(const std::string& path)
+			{
+				std::ofstream file(path);
+				if (!file)
+				{
+					throw std::runtime_error("Error: Cannot open the stats file " + path);
+				}
+
+				std::lock_guard<std::mutex> lock(gMutex);
+				ThreadCounters total;
+				for (const auto& counters : gThreadCounters)
+				{
+					for (int i = 0; i < static_cast<int>(Counter::SIZE); ++i)
+					{
+						total.counters[i] += counters->counters[i];
+					}
+					for (int i = 0; i <= cMaxPathLength; ++i)
+					{
+						total.path_lengths[i] += counters->path_lengths[i];
+					}
+				}
+				auto get = [&total](Counter counter) { return total.counters[static_cast<int>(counter)]; };
+
+				auto numof_rays = get(Counter::CLOSEST_HIT_RAYS) + get(Counter::SHADOW_RAYS);
+				auto render_time = gPhaseTimes.count("Render") ? gPhaseTimes["Render"] : 0.0;
+
+				file << "{\n";
+				file << "  \"enabled\": " << (cEnabled ? "true" : "false") << ",\n";
+				file << "  \"counters\": {\n";
+				for (int i = 0; i < static_cast<int>(Counter::SIZE); ++i)
+				{
+					file << "    \"" << cCounterNames[i] << "\": " << total.counters[i] << ",\n";
+				}
+				file << "    \"total_rays\": " << numof_rays << "\n";
+				file << "  },\n";
+				file << "  \"mrays_per_second\": " << divide(numof_rays * 1e-6, render_time) << ",\n";
+				file << "  \"bvh_nodes_per_ray\": " << divide(get(Counter::BVH_NODES_VISITED), numof_rays) << ",\n";
+				file << "  \"primitives_per_ray\": " << divide(get(Counter::PRIMITIVES_TESTED), numof_rays) << ",\n";
+				file << "  \"path_length_histogram\": [";
+				for (int i = 0; i <= cMaxPathLength; ++i)
+				{
+					file << (i ? ", " : "") << total.path_lengths[i];
+				}
+				file << "],\n";
+				file << "  \"phases\": {";
+				bool first = true;
+				for (const auto& phase : gPhaseTimes)
+				{
+					file << (first ? "\n" : ",\n") << "    \"" << phase.first << "\": " << phase.second;
+					first = false;
+				}
+				file << "\n  },\n";
+				file << "  \"memory\": ";
+				memory::writeJson(file, "  ");
+				file << "\n}\n";
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#ifndef __GLUE__CORE__STATS__
+#define __GLUE__CORE__STATS__
+
+#include "timer.h"
+#include "trace.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace glue
+{
+	namespace core
+	{
+		//Per-ray counters are collected only if GLUE_STATS is defined. Otherwise they compile to nothing.
+		//Phase times are coarse enough to be always collected.
+		namespace stats
+		{
+#ifdef GLUE_STATS
+			constexpr bool cEnabled = true;
+#else
+			constexpr bool cEnabled = false;
+#endif
+
+			enum class Counter
+			{
+				CAMERA_RAYS,
+				BOUNCE_RAYS,
+				PHOTON_RAYS,
+				SHADOW_RAYS, //All calls to Scene::intersectShadowRay.
+				CLOSEST_HIT_RAYS, //All calls to Scene::intersect, including the ones above and light visibility tests.
+				BVH_NODES_VISITED, //Summed over the scene BVH and the BVHs of the meshes.
+				PRIMITIVES_TESTED,
+				RR_TERMINATIONS,
+				SIZE
+			};
+
+			//Camera paths longer than this are counted in the last bin of the histogram.
+			constexpr int cMaxPathLength = 32;
+
+			//Every thread owns a set of counters so that counting needs no synchronization.
+			//The report sums them up, so it has to be written while no thread is counting.
+			struct ThreadCounters
+			{
+				std::array<std::uint64_t, static_cast<int>(Counter::SIZE)> counters{};
+				std::array<std::uint64_t, cMaxPathLength + 1> path_lengths{};
+			};
+
+			//Counters live until the end of the program, so threads of a restarted pool add up with the old ones.
+			ThreadCounters* registerThread();
+
+			inline ThreadCounters& getThreadCounters()
+			{
+				thread_local ThreadCounters* counters = registerThread();
+				return *counters;
+			}
+
+			inline void add(Counter counter, std::uint64_t value = 1)
+			{
+				if constexpr (cEnabled)
+				{
+					getThreadCounters().counters[static_cast<int>(counter)] += value;
+				}
+			}
+
+			//Length is the number of segments of the path, so a camera ray that escapes the scene has a length of 1.
+			inline void addPathLength(int length)
+			{
+				if constexpr (cEnabled)
+				{
+					getThreadCounters().path_lengths[length < cMaxPathLength ? length : cMaxPathLength] += 1;
+				}
+			}
+
+			//Adds the traversal steps of a ray to the counters when it goes out of scope.
+			struct TraversalCounter
+			{
+				std::uint64_t nodes_visited = 0;
+				std::uint64_t primitives_tested = 0;
+
+				~TraversalCounter()
+				{
+					add(Counter::BVH_NODES_VISITED, nodes_visited);
+					add(Counter::PRIMITIVES_TESTED, primitives_tested);
+				}
+			};
+
+			//Times of the phases with the same name add up.
+			void addPhaseTime(const std::string& phase, double seconds);
+			//Returns 0 for phases that are not recorded.
+			double getPhaseTime(const std::string& phase);
+
+			//Sums the counter over all threads. It has to be called while no thread is counting.
+			std::uint64_t getTotal(Counter counter);
+			//Zeroes the counters and the phase times, so that consecutive renders can be measured separately.
+			void reset();
+
+			//Measures the wall time of the enclosing scope as a phase. It is also recorded as an event of the trace.
+			class ScopedPhase
+			{
+			public:
+				explicit ScopedPhase(const char* phase);
+				~ScopedPhase();
+
+			private:
+				const char* m_phase;
+				Timer m_timer;
+				trace::Scope m_trace_scope;
+			};
+
+			//Mrays/s is computed over the "Render" phase.
+			void writeReport(const std::string& path);
+		}
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,277 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace glue
+{
+	namespace core
+	{
+		namespace
+		{
+			thread_local int tWorkerIndex = -1;
+			thread_local bool tSerial = false;
+			thread_local int tDepth = 0; //Depth of the task running on the thread.
+
+			std::unique_ptr<ThreadPool> gPool;
+			std::mutex gPoolMutex;
+
+			//Returns the cpu limit of the cgroup of the process, or 0 if there is none.
+			float getCgroupCpuLimit()
+			{
+				float quota = 0.0f;
+				float period = 0.0f;
+
+				//cgroup v2 writes "max 100000" if there is no limit, which fails to parse as a number.
+				std::ifstream cpu_max("/sys/fs/cgroup/cpu.max");
+				if (cpu_max >> quota >> period)
+				{
+					return period > 0.0f ? quota / period : 0.0f;
+				}
+
+				//cgroup v1 writes -1 if there is no limit.
+				std::ifstream cfs_quota("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+				std::ifstream cfs_period("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+				if (cfs_quota >> quota && cfs_period >> period && quota > 0.0f && period > 0.0f)
+				{
+					return quota / period;
+				}
+
+				return 0.0f;
+			}
+		}
+
+		//TaskGroup
+		ThreadPool::TaskGroup::TaskGroup(ThreadPool& pool)
+			: m_pool(pool)
+			, m_pending(0)
+		{}
+
+		ThreadPool::TaskGroup::~TaskGroup()
+		{
+			//Tasks refer to the group, so it cannot be destroyed before they are done.
+			try
+			{
+				wait();
+			}
+			catch (...)
+			{}
+		}
+
+		void ThreadPool::TaskGroup::run(std::function<void()> task)
+		{
+			if (m_pool.isSerial())
+			{
+				task();
+			}
+			else
+			{
+				m_pool.push(Task{ std::move(task), this, tDepth + 1 });
+			}
+		}
+
+		void ThreadPool::TaskGroup::wait()
+		{
+			m_pool.wait(*this);
+		}
+
+		//SerialScope
+		ThreadPool::SerialScope::SerialScope()
+			: m_previous(tSerial)
+		{
+			tSerial = true;
+		}
+
+		ThreadPool::SerialScope::~SerialScope()
+		{
+			tSerial = m_previous;
+		}
+
+		//ThreadPool
+		ThreadPool::ThreadPool(int numof_workers, const std::function<void(int)>& initializer)
+			: m_numof_idle(0)
+			, m_stopped(false)
+		{
+			//Workers are started one after the other so that the initializer never runs concurrently with the caller.
+			for (int i = 0; i < numof_workers; ++i)
+			{
+				std::mutex started_mutex;
+				std::condition_variable started_condition;
+				bool started = false;
+				m_workers.emplace_back([this, i, &initializer, &started_mutex, &started_condition, &started]()
+				{
+					tWorkerIndex = i;
+					if (initializer)
+					{
+						initializer(i);
+					}
+					{
+						//Notified under the lock since the condition is destroyed as soon as the constructor sees the flag.
+						std::lock_guard<std::mutex> lock(started_mutex);
+						started = true;
+						started_condition.notify_one();
+					}
+
+					std::unique_lock<std::mutex> lock(m_mutex);
+					while (true)
+					{
+						++m_numof_idle;
+						m_condition.wait(lock, [this]() { return m_stopped || !m_tasks.empty(); });
+						--m_numof_idle;
+						if (m_tasks.empty())
+						{
+							return;
+						}
+						runTask(lock, m_tasks.begin());
+					}
+				});
+
+				std::unique_lock<std::mutex> lock(started_mutex);
+				started_condition.wait(lock, [&started]() { return started; });
+			}
+		}
+
+		ThreadPool::~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stopped = true;
+			}
+			m_condition.notify_all();
+			for (auto& worker : m_workers)
+			{
+				worker.join();
+			}
+		}
+
+		ThreadPool& ThreadPool::get()
+		{
+			std::lock_guard<std::mutex> lock(gPoolMutex);
+			if (!gPool)
+			{
+				gPool = std::make_unique<ThreadPool>(getDefaultWorkerCount(), nullptr);
+			}
+
+			return *gPool;
+		}
+
+		void ThreadPool::configure(int numof_workers, const std::function<void(int)>& initializer)
+		{
+			std::lock_guard<std::mutex> lock(gPoolMutex);
+			gPool.reset();
+			gPool = std::make_unique<ThreadPool>(numof_workers > 0 ? numof_workers : getDefaultWorkerCount(), initializer);
+		}
+
+		int ThreadPool::getDefaultWorkerCount()
+		{
+			int count = std::thread::hardware_concurrency();
+#ifdef __linux__
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0)
+			{
+				count = CPU_COUNT(&cpus);
+			}
+
+			auto cpu_limit = getCgroupCpuLimit();
+			if (cpu_limit > 0.0f)
+			{
+				count = std::min(count, static_cast<int>(std::ceil(cpu_limit)));
+			}
+#endif
+			return std::max(count, 1);
+		}
+
+		int ThreadPool::getWorkerIndex()
+		{
+			return tWorkerIndex;
+		}
+
+		void ThreadPool::push(Task task)
+		{
+			bool idle;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				++task.group->m_pending;
+				m_tasks.push_back(std::move(task));
+				idle = m_numof_idle > 0;
+			}
+			//Every task wakes a single thread. An idle worker can run any task. If there is none, a waiting worker may run it as a nested task.
+			//The thread that pushes a task checks the queue before it waits itself, so a wakeup that reaches the wrong thread never stalls the group.
+			if (idle)
+			{
+				m_condition.notify_one();
+			}
+			else
+			{
+				m_wait_condition.notify_one();
+			}
+		}
+
+		void ThreadPool::wait(TaskGroup& group)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (group.m_pending > 0)
+			{
+				//Waiting workers run the nested tasks, which is what keeps the nested loops from deadlocking.
+				auto task_iter = std::find_if(m_tasks.begin(), m_tasks.end(), [](const Task& task) { return task.depth > tDepth; });
+				if (tWorkerIndex >= 0 && task_iter != m_tasks.end())
+				{
+					runTask(lock, task_iter);
+				}
+				else
+				{
+					m_wait_condition.wait(lock);
+				}
+			}
+
+			if (group.m_error)
+			{
+				auto error = group.m_error;
+				group.m_error = nullptr;
+				std::rethrow_exception(error);
+			}
+		}
+
+		void ThreadPool::runTask(std::unique_lock<std::mutex>& lock, std::deque<Task>::iterator task_iter)
+		{
+			auto task = std::move(*task_iter);
+			m_tasks.erase(task_iter);
+			lock.unlock();
+
+			auto previous_depth = tDepth;
+			tDepth = task.depth;
+			std::exception_ptr error;
+			try
+			{
+				task.function();
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+			tDepth = previous_depth;
+
+			lock.lock();
+			if (error && !task.group->m_error)
+			{
+				task.group->m_error = error;
+			}
+			if (--task.group->m_pending == 0)
+			{
+				m_wait_condition.notify_all();
+			}
+		}
+
+		bool ThreadPool::isSerial() const
+		{
+			return tSerial || m_workers.size() < 2;
+		}
+	}
+}
\ No newline at end of file
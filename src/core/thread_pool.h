@@ -0,0 +1,111 @@
+#ifndef __GLUE__CORE__THREADPOOL__
+#define __GLUE__CORE__THREADPOOL__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace glue
+{
+	namespace core
+	{
+		//All of the parallel work of the renderer runs on a single set of workers: BVH builds, asset loading, render passes and output encoding.
+		//Tasks go into one shared queue. A worker that waits for a task group runs queued tasks meanwhile,
+		//so nested parallel loops never run on more threads than there are workers.
+		//It only runs tasks nested deeper than the one it waits in, so that it never picks up work that may wait for itself,
+		//such as another object that needs the model it is loading.
+		//Threads that are not workers only block while they wait, they never run tasks.
+		class ThreadPool
+		{
+		public:
+			//Tasks run by a group can be waited for together. Waiting rethrows the first exception thrown by its tasks.
+			class TaskGroup
+			{
+			public:
+				explicit TaskGroup(ThreadPool& pool);
+				~TaskGroup();
+				TaskGroup(const TaskGroup&) = delete;
+				TaskGroup& operator=(const TaskGroup&) = delete;
+
+				void run(std::function<void()> task);
+				void wait();
+
+			private:
+				ThreadPool& m_pool;
+				int m_pending; //Guarded by the mutex of the pool.
+				std::exception_ptr m_error;
+
+				friend class ThreadPool;
+			};
+
+			//Parallel loops started by the thread that creates it run inline until it is destroyed.
+			//It keeps the allocations of a loop on the NUMA node of a pinned thread.
+			class SerialScope
+			{
+			public:
+				SerialScope();
+				~SerialScope();
+
+			private:
+				bool m_previous;
+			};
+
+		public:
+			//The initializer is called once on every worker before it takes any task.
+			ThreadPool(int numof_workers, const std::function<void(int)>& initializer);
+			~ThreadPool();
+			ThreadPool(const ThreadPool&) = delete;
+			ThreadPool& operator=(const ThreadPool&) = delete;
+
+			//Calls function(index, worker) for every index in [begin, end). Chunks of chunk_size indices are handed out dynamically.
+			//worker is the index of the worker running the call, so it can address per-worker state of get_worker_count() entries.
+			template<typename Function>
+			void parallelFor(int begin, int end, int chunk_size, const Function& function);
+
+			int get_worker_count() const { return m_workers.size(); }
+
+			//Shared pool of the renderer. It is started with getDefaultWorkerCount() workers on first use.
+			static ThreadPool& get();
+			//Restarts the shared pool. It must not be called while the pool runs tasks.
+			static void configure(int numof_workers, const std::function<void(int)>& initializer = nullptr);
+			//Number of cpus the process may use, taking the affinity mask and the cgroup cpu quota into account.
+			static int getDefaultWorkerCount();
+			//Index of the calling worker, or -1 if the calling thread is not a worker.
+			static int getWorkerIndex();
+
+		private:
+			struct Task
+			{
+				std::function<void()> function;
+				TaskGroup* group;
+				int depth; //One more than the depth of the task that pushed it. Tasks pushed by other threads are at depth 1.
+			};
+
+		private:
+			std::vector<std::thread> m_workers;
+			std::deque<Task> m_tasks;
+			std::mutex m_mutex;
+			std::condition_variable m_condition; //Idle workers sleep on it until there is a task.
+			std::condition_variable m_wait_condition; //Threads waiting for a task group sleep on it.
+			int m_numof_idle; //Workers sleeping on m_condition.
+			bool m_stopped;
+
+		private:
+			void push(Task task);
+			void wait(TaskGroup& group);
+			//Removes the task from the queue and runs it. The lock is released while the task runs.
+			void runTask(std::unique_lock<std::mutex>& lock, std::deque<Task>::iterator task_iter);
+			bool isSerial() const;
+		};
+	}
+}
+
+#include "thread_pool.inl"
+
+#endif
\ No newline at end of file
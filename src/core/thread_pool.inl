@@ -0,0 +1,48 @@
+#include <algorithm>
+
+namespace glue
+{
+	namespace core
+	{
+		template<typename Function>
+		void ThreadPool::parallelFor(int begin, int end, int chunk_size, const Function& function)
+		{
+			if (begin >= end)
+			{
+				return;
+			}
+
+			if (isSerial())
+			{
+				int worker = std::max(getWorkerIndex(), 0);
+				for (int i = begin; i < end; ++i)
+				{
+					function(i, worker);
+				}
+
+				return;
+			}
+
+			//Every task keeps taking chunks until the range runs out, so there is no need for more tasks than workers.
+			std::atomic<int> next(begin);
+			int numof_chunks = (end - begin + chunk_size - 1) / chunk_size;
+			int numof_tasks = std::min(numof_chunks, get_worker_count());
+			TaskGroup group(*this);
+			for (int t = 0; t < numof_tasks; ++t)
+			{
+				group.run([&next, end, chunk_size, &function]()
+				{
+					int worker = getWorkerIndex();
+					for (int start = next.fetch_add(chunk_size); start < end; start = next.fetch_add(chunk_size))
+					{
+						for (int i = start; i < std::min(start + chunk_size, end); ++i)
+						{
+							function(i, worker);
+						}
+					}
+				});
+			}
+			group.wait();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "tile_scheduler.h"
+
+#include <glm/common.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace glue
+{
+	namespace core
+	{
+		namespace
+		{
+			//Distance of the cell along the Hilbert curve covering a n x n grid, where n is a power of two.
+			int hilbertDistance(int n, int x, int y)
+			{
+				int distance = 0;
+				for (int s = n / 2; s > 0; s /= 2)
+				{
+					int rx = (x & s) > 0;
+					int ry = (y & s) > 0;
+					distance += s * s * ((3 * rx) ^ ry);
+
+					if (ry == 0)
+					{
+						if (rx == 1)
+						{
+							x = s - 1 - x;
+							y = s - 1 - y;
+						}
+						std::swap(x, y);
+					}
+				}
+
+				return distance;
+			}
+		}
+
+		TileScheduler::TileScheduler(const std::vector<Tile>& tiles, const glm::ivec2& resolution, int min_tile_size, int numof_workers,
+			const std::vector<int>& worker_nodes)
+			: m_queues(numof_workers)
+			, m_worker_nodes(worker_nodes)
+			, m_resolution(resolution)
+			, m_min_tile_size(min_tile_size)
+		{
+			//Every worker starts on a contiguous run of the ordered tiles, so that the tiles it renders stay close to each other.
+			int size = tiles.size();
+			for (int w = 0; w < numof_workers; ++w)
+			{
+				auto begin = tiles.begin() + static_cast<long long>(size) * w / numof_workers;
+				auto end = tiles.begin() + static_cast<long long>(size) * (w + 1) / numof_workers;
+				m_queues[w].tiles.assign(begin, end);
+			}
+		}
+
+		bool TileScheduler::next(int worker, Tile& tile)
+		{
+			{
+				auto& queue = m_queues[worker];
+				std::lock_guard<std::mutex> lock(queue.mutex);
+				if (!queue.tiles.empty())
+				{
+					tile = queue.tiles.front();
+					queue.tiles.pop_front();
+					return true;
+				}
+			}
+
+			return (!m_worker_nodes.empty() && steal(worker, tile, true)) || steal(worker, tile, false);
+		}
+
+		bool TileScheduler::steal(int worker, Tile& tile, bool same_node)
+		{
+			int numof_workers = m_queues.size();
+			for (int i = 1; i < numof_workers; ++i)
+			{
+				int victim_index = (worker + i) % numof_workers;
+				if (same_node && m_worker_nodes[victim_index] != m_worker_nodes[worker])
+				{
+					continue;
+				}
+
+				auto& victim = m_queues[victim_index];
+				{
+					std::lock_guard<std::mutex> lock(victim.mutex);
+					if (victim.tiles.empty())
+					{
+						continue;
+					}
+					tile = victim.tiles.back();
+					victim.tiles.pop_back();
+				}
+
+				if (tile.size > m_min_tile_size)
+				{
+					//Keep the first quadrant and queue the others that overlap with the image.
+					auto half_size = tile.size / 2;
+					auto& queue = m_queues[worker];
+					std::lock_guard<std::mutex> lock(queue.mutex);
+					for (int q = 1; q < 4; ++q)
+					{
+						auto origin = tile.origin + glm::ivec2(q & 1, q >> 1) * half_size;
+						if (origin.x < m_resolution.x && origin.y < m_resolution.y)
+						{
+							queue.tiles.emplace_back(origin, half_size, tile.index);
+						}
+					}
+					tile.size = half_size;
+				}
+
+				return true;
+			}
+
+			return false;
+		}
+
+		std::vector<glm::ivec2> TileScheduler::orderTiles(const glm::ivec2& resolution, int tile_size, TileOrder order)
+		{
+			glm::ivec2 numof_tiles((resolution.x + tile_size - 1) / tile_size, (resolution.y + tile_size - 1) / tile_size);
+			std::vector<glm::ivec2> cells;
+			for (int y = 0; y < numof_tiles.y; ++y)
+			{
+				for (int x = 0; x < numof_tiles.x; ++x)
+				{
+					cells.emplace_back(x, y);
+				}
+			}
+
+			if (order == TileOrder::HILBERT)
+			{
+				int n = 1;
+				while (n < glm::max(numof_tiles.x, numof_tiles.y))
+				{
+					n *= 2;
+				}
+				std::stable_sort(cells.begin(), cells.end(), [n](const glm::ivec2& a, const glm::ivec2& b)
+				{
+					return hilbertDistance(n, a.x, a.y) < hilbertDistance(n, b.x, b.y);
+				});
+			}
+			else if (order == TileOrder::SPIRAL)
+			{
+				//Rings around the center, each ring in angular order.
+				glm::vec2 center = glm::vec2(numof_tiles - 1) * 0.5f;
+				auto ring = [&center](const glm::ivec2& cell)
+				{
+					auto d = glm::abs(glm::vec2(cell) - center);
+					return static_cast<int>(glm::max(d.x, d.y) + 0.5f);
+				};
+				auto angle = [&center](const glm::ivec2& cell)
+				{
+					return std::atan2(cell.y - center.y, cell.x - center.x);
+				};
+				std::stable_sort(cells.begin(), cells.end(), [&ring, &angle](const glm::ivec2& a, const glm::ivec2& b)
+				{
+					auto ring_a = ring(a);
+					auto ring_b = ring(b);
+					return ring_a != ring_b ? ring_a < ring_b : angle(a) < angle(b);
+				});
+			}
+
+			for (auto& cell : cells)
+			{
+				cell *= tile_size;
+			}
+
+			return cells;
+		}
+
+		TileOrder TileScheduler::parseTileOrder(const std::string& order)
+		{
+			if (order == "Scanline")
+			{
+				return TileOrder::SCANLINE;
+			}
+			else if (order == "Hilbert")
+			{
+				return TileOrder::HILBERT;
+			}
+			else if (order == "Spiral")
+			{
+				return TileOrder::SPIRAL;
+			}
+
+			throw std::runtime_error("Error: Unknown TileOrder " + order);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef __GLUE__CORE__TILESCHEDULER__
+#define __GLUE__CORE__TILESCHEDULER__
+
+#include "forward_decl.h"
+
+#include <glm/vec2.hpp>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace glue
+{
+	namespace core
+	{
+		enum class TileOrder
+		{
+			SCANLINE,
+			HILBERT,
+			SPIRAL
+		};
+
+		struct Tile
+		{
+			glm::ivec2 origin;
+			int size;
+			int index; //Caller defined index of the tile. Tiles split from it keep it.
+
+			Tile() = default;
+			Tile(const glm::ivec2& p_origin, int p_size, int p_index)
+				: origin(p_origin)
+				, size(p_size)
+				, index(p_index)
+			{}
+		};
+
+		//The ordered tiles are split into contiguous runs, one per worker deque. Workers take tiles from the front of their own deque,
+		//and steal from the back of the others when it runs out, which is the part of the run farthest from where the victim works. Stolen tiles larger than the minimum size are split into quadrants
+		//so that the tail of the render is balanced with small tiles while the bulk of it runs on large ones.
+		//If the NUMA nodes of the workers are given, victims on the same node are tried before the others.
+		class TileScheduler
+		{
+		public:
+			TileScheduler(const std::vector<Tile>& tiles, const glm::ivec2& resolution, int min_tile_size, int numof_workers,
+				const std::vector<int>& worker_nodes = std::vector<int>());
+
+			//Returns false when there is no tile left to take or steal.
+			bool next(int worker, Tile& tile);
+
+			//Returns the origins of the tiles covering the image in the given order. Scanline order goes row by row.
+			static std::vector<glm::ivec2> orderTiles(const glm::ivec2& resolution, int tile_size, TileOrder order);
+			static TileOrder parseTileOrder(const std::string& order);
+
+		private:
+			//Every queue gets its own cache line, since its owner locks it for every tile.
+			struct alignas(64) WorkerQueue
+			{
+				std::mutex mutex;
+				std::deque<Tile> tiles;
+			};
+
+		private:
+			std::vector<WorkerQueue> m_queues;
+			std::vector<int> m_worker_nodes;
+			glm::ivec2 m_resolution;
+			int m_min_tile_size;
+
+		private:
+			bool steal(int worker, Tile& tile, bool same_node);
+		};
+	}
+}
+
+#endif
\ No newline at end of file
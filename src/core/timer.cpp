@@ -9,7 +9,7 @@ namespace glue
 			m_start_time = std::chrono::system_clock::now();
 		}
 
-		double Timer::getTime()
+		double Timer::getTime() const
 		{
 			using second = std::chrono::duration<double, std::ratio<1>>;
 			return std::chrono::duration_cast<second>(std::chrono::system_clock::now() - m_start_time).count();
@@ -11,7 +11,7 @@ namespace glue
 		{
 		public:
 			void start();
-			double getTime();
+			double getTime() const;
 
 		private:
 			std::chrono::time_point<std::chrono::system_clock> m_start_time{std::chrono::system_clock::now()};
@@ -50,13 +50,15 @@ namespace glue
 			int width = tonemapped_image.get_width();
 			int height = tonemapped_image.get_height();
 
-			for (int i = 0; i < width; ++i)
+			std::vector<glm::vec3> row(width);
+			for (int j = 0; j < height; ++j)
 			{
-				for (int j = 0; j < height; ++j)
+				tonemapped_image.getRow(j, row);
+				for (auto& pixel : row)
 				{
-					auto pixel = tonemapped_image.get(i, j);
-					tonemapped_image.set(i, j, glm::clamp(pixel, m_min, m_max));
+					pixel = glm::clamp(pixel, m_min, m_max);
 				}
+				tonemapped_image.setRow(j, row);
 			}
 
 			return tonemapped_image;
@@ -87,12 +89,12 @@ namespace glue
 			constexpr auto epsilon = 0.0001f;
 			auto geometric_average = 0.0f;
 			auto max_l_t = 0.0f;
-			for (int i = 0; i < width; ++i)
+			std::vector<glm::vec3> row(width);
+			for (int j = 0; j < height; ++j)
 			{
-				for (int j = 0; j < height; ++j)
+				tonemapped_image.getRow(j, row);
+				for (const auto& pixel : row)
 				{
-					auto pixel = tonemapped_image.get(i, j);
-
 					auto luminance = math::rgbToLuminance(pixel);
 					max_l_t = glm::max(luminance, max_l_t);
 
@@ -104,17 +106,17 @@ namespace glue
 
 			max_l_t *= (scale * m_max_luminance);
 
-			for (int i = 0; i < width; ++i)
+			for (int j = 0; j < height; ++j)
 			{
-				for (int j = 0; j < height; ++j)
+				tonemapped_image.getRow(j, row);
+				for (auto& pixel : row)
 				{
-					auto pixel = tonemapped_image.get(i, j);
-
 					auto l_t = scale * math::rgbToLuminance(pixel);
 
 					pixel *= scale * (1.0f + l_t / (max_l_t * max_l_t)) / (1.0f + l_t);
-					tonemapped_image.set(i, j, glm::clamp(pixel, 0.0f, 1.0f));
+					pixel = glm::clamp(pixel, 0.0f, 1.0f);
 				}
+				tonemapped_image.setRow(j, row);
 			}
 
 			return tonemapped_image;
@@ -0,0 +1,123 @@
+#include "trace.h"
+#include "thread_pool.h"
+#include "json.h"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace glue
+{
+	namespace core
+	{
+		namespace trace
+		{
+			std::atomic<bool> gEnabled(false);
+
+			namespace
+			{
+				struct Event
+				{
+					const char* name;
+					std::string detail;
+					std::int64_t start;
+					std::int64_t duration;
+				};
+
+				struct ThreadEvents
+				{
+					int id;
+					int worker; //Index in the thread pool, or -1 if the thread is not a worker.
+					std::vector<Event> events;
+				};
+
+				std::mutex gMutex;
+				std::vector<std::unique_ptr<ThreadEvents>> gThreadEvents;
+				const auto gEpoch = std::chrono::steady_clock::now();
+
+				std::int64_t getTime()
+				{
+					return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - gEpoch).count();
+				}
+
+				//Threads of a restarted pool get their own lists, so that the old events are kept.
+				ThreadEvents& getThreadEvents()
+				{
+					thread_local ThreadEvents* events = []()
+					{
+						std::lock_guard<std::mutex> lock(gMutex);
+						gThreadEvents.push_back(std::make_unique<ThreadEvents>());
+						gThreadEvents.back()->id = gThreadEvents.size();
+						gThreadEvents.back()->worker = ThreadPool::getWorkerIndex();
+						return gThreadEvents.back().get();
+					}();
+					return *events;
+				}
+			}
+
+			void enable()
+			{
+				gEnabled.store(true, std::memory_order_relaxed);
+			}
+
+			Scope::Scope(const char* name)
+				: m_name(name)
+				, m_start(isEnabled() ? getTime() : -1)
+			{}
+
+			Scope::Scope(const char* name, const std::string& detail)
+				: m_name(name)
+				, m_start(-1)
+			{
+				if (isEnabled())
+				{
+					m_detail = detail;
+					m_start = getTime();
+				}
+			}
+
+			Scope::~Scope()
+			{
+				if (m_start >= 0)
+				{
+					getThreadEvents().events.push_back(Event{ m_name, std::move(m_detail), m_start, getTime() - m_start });
+				}
+			}
+
+			void write(const std::string& path)
+			{
+				std::ofstream file(path);
+				if (!file)
+				{
+					throw std::runtime_error("Error: Cannot open the trace file " + path);
+				}
+
+				std::lock_guard<std::mutex> lock(gMutex);
+				file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+				bool first = true;
+				for (const auto& thread : gThreadEvents)
+				{
+					auto thread_name = thread->worker >= 0 ? "Worker " + std::to_string(thread->worker) : "Thread " + std::to_string(thread->id);
+					file << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread->id <<
+						", \"args\": {\"name\": \"" << thread_name << "\"}}";
+					first = false;
+
+					for (const auto& event : thread->events)
+					{
+						file << ",\n{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << thread->id <<
+							", \"ts\": " << event.start << ", \"dur\": " << event.duration;
+						if (!event.detail.empty())
+						{
+							file << ", \"args\": {\"detail\": \"" << json::escape(event.detail) << "\"}";
+						}
+						file << "}";
+					}
+				}
+				file << "\n]}\n";
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef __GLUE__CORE__TRACE__
+#define __GLUE__CORE__TRACE__
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace glue
+{
+	namespace core
+	{
+		//Opt-in timeline of the scoped events of every thread. It is written in the Chrome trace format,
+		//which chrome://tracing and Perfetto open. While it is disabled, a scope costs a single load.
+		namespace trace
+		{
+			extern std::atomic<bool> gEnabled;
+
+			//Events are only recorded after this is called.
+			void enable();
+
+			inline bool isEnabled()
+			{
+				return gEnabled.load(std::memory_order_relaxed);
+			}
+
+			//Records the enclosing scope as an event of the calling thread.
+			class Scope
+			{
+			public:
+				explicit Scope(const char* name);
+				//Detail is shown as an argument of the event, such as the path of a loaded file.
+				Scope(const char* name, const std::string& detail);
+				~Scope();
+				Scope(const Scope&) = delete;
+				Scope& operator=(const Scope&) = delete;
+
+			private:
+				const char* m_name;
+				std::string m_detail;
+				std::int64_t m_start; //In microseconds. Negative if the tracer was disabled at construction.
+			};
+
+			//Every thread owns its events, so the trace has to be written while no thread is recording.
+			void write(const std::string& path);
+		}
+	}
+}
+
+#endif
\ No newline at end of file
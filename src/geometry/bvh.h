@@ -11,6 +11,9 @@ namespace glue
 {
 	namespace geometry
 	{
+		//Entries of the traversal stack. A tree whose leaves are deeper than one less than this overflows it.
+		constexpr int cBVHStackSize = 32;
+
 		struct BVHNode
 		{
 			BBox bbox;
@@ -40,6 +43,8 @@ namespace glue
 			void buildWithSAHSplit();
 			bool intersect(const Ray& ray, Intersection& intersection, float max_distance) const;
 			bool intersectShadowRay(const Ray& ray, float max_distance) const;
+			std::size_t getNodeMemoryUsage() const;
+			std::size_t getPrimitiveMemoryUsage() const { return m_objects.capacity() * sizeof(Primitive); }
 
 			const std::vector<Primitive>& get_objects() const { return m_objects; }
 			const std::unique_ptr<BVHNode>& get_root() const { return m_root; }
@@ -1,9 +1,12 @@
 #include "ray.h"
 #include "intersection.h"
+#include "../core/stats.h"
+#include "../core/thread_pool.h"
+#include "../core/trace.h"
 
 #include <algorithm>
 #include <array>
-#include <thread>
+#include <limits>
 #include <type_traits>
 
 //A trick to check if the type has operator ->
@@ -29,13 +32,15 @@ namespace glue
 		template<typename Primitive>
 		void BVH<Primitive>::buildWithMedianSplit()
 		{
+			core::trace::Scope scope("Build BVH (median split)", std::to_string(m_objects.size()) + " primitives");
 			m_root = std::make_unique<BVHNode>(0, m_objects.size());
-			buildWithMedianSplitWork(&m_root, std::thread::hardware_concurrency());
+			buildWithMedianSplitWork(&m_root, core::ThreadPool::get().get_worker_count());
 		}
 
 		template<typename Primitive>
 		void BVH<Primitive>::buildWithSAHSplit()
 		{
+			core::trace::Scope scope("Build BVH (SAH split)", std::to_string(m_objects.size()) + " primitives");
 			int size = m_objects.size();
 			BBox temp;
 			for (int i = 0; i < size; ++i)
@@ -50,7 +55,7 @@ namespace glue
 				}
 			}
 			m_root = std::make_unique<BVHNode>(temp, 0, size);
-			buildWithSAHSplitWork(&m_root, static_cast<float>(std::thread::hardware_concurrency()));
+			buildWithSAHSplitWork(&m_root, static_cast<float>(core::ThreadPool::get().get_worker_count()));
 		}
 
 		template<typename Primitive>
@@ -104,10 +109,10 @@ namespace glue
 
 			if (work > 1)
 			{
-				std::thread th1(&BVH<Primitive>::buildWithMedianSplitWork, this, &ref_node->right, work >> 1);
-				std::thread th2(&BVH<Primitive>::buildWithMedianSplitWork, this, &ref_node->left, work >> 1);
-				th2.join();
-				th1.join();
+				core::ThreadPool::TaskGroup group(core::ThreadPool::get());
+				group.run([this, &ref_node, work]() { buildWithMedianSplitWork(&ref_node->right, work >> 1); });
+				buildWithMedianSplitWork(&ref_node->left, work >> 1);
+				group.wait();
 			}
 			else
 			{
@@ -210,10 +215,10 @@ namespace glue
 			if (work > 0.5f)
 			{
 				auto right_work = work * (static_cast<float>(right_count) / (ref_node->end - ref_node->start));
-				std::thread th1(&BVH<Primitive>::buildWithSAHSplitWork, this, &ref_node->right, right_work);
-				std::thread th2(&BVH<Primitive>::buildWithSAHSplitWork, this, &ref_node->left, work - right_work);
-				th2.join();
-				th1.join();
+				core::ThreadPool::TaskGroup group(core::ThreadPool::get());
+				group.run([this, &ref_node, right_work]() { buildWithSAHSplitWork(&ref_node->right, right_work); });
+				buildWithSAHSplitWork(&ref_node->left, work - right_work);
+				group.wait();
 			}
 			else
 			{
@@ -225,15 +230,17 @@ namespace glue
 		template<typename Primitive>
 		bool BVH<Primitive>::intersect(const Ray& ray, Intersection& intersection, float max_distance) const
 		{
-			std::array<BVHNode*, 32> stack;
+			std::array<BVHNode*, cBVHStackSize> stack;
 			int stack_size = 0;
 			stack[stack_size++] = m_root.get();
 			auto inv_dir = 1.0f / ray.get_direction();
+			core::stats::TraversalCounter traversal;
 
 			auto min_distance = max_distance;
 			while (stack_size)
 			{
 				auto top = stack[--stack_size];
+				++traversal.nodes_visited;
 
 				auto result = top->bbox.intersect(ray.get_origin(), inv_dir);
 				if (result.x > 0.0f && result.y < min_distance)
@@ -249,6 +256,7 @@ namespace glue
 					{
 						for (int i = top->start; i < top->end; ++i)
 						{
+							++traversal.primitives_tested;
 							if constexpr (isDereferenceable<Primitive>::value)
 							{
 								if (m_objects[i]->intersect(ray, intersection, min_distance))
@@ -274,14 +282,16 @@ namespace glue
 		template<typename Primitive>
 		bool BVH<Primitive>::intersectShadowRay(const Ray& ray, float max_distance) const
 		{
-			std::array<BVHNode*, 32> stack;
+			std::array<BVHNode*, cBVHStackSize> stack;
 			int stack_size = 0;
 			stack[stack_size++] = m_root.get();
 			auto inv_dir = 1.0f / ray.get_direction();
+			core::stats::TraversalCounter traversal;
 
 			while (stack_size)
 			{
 				auto top = stack[--stack_size];
+				++traversal.nodes_visited;
 
 				auto result = top->bbox.intersect(ray.get_origin(), inv_dir);
 				if (result.x > 0.0f && result.y < max_distance)
@@ -295,6 +305,7 @@ namespace glue
 					{
 						for (int i = top->start; i < top->end; ++i)
 						{
+							++traversal.primitives_tested;
 							if constexpr (isDereferenceable<Primitive>::value)
 							{
 								if (m_objects[i]->intersectShadowRay(ray, max_distance))
@@ -317,5 +328,32 @@ namespace glue
 
 			return false;
 		}
+
+		template<typename Primitive>
+		std::size_t BVH<Primitive>::getNodeMemoryUsage() const
+		{
+			std::size_t numof_nodes = 0;
+			std::vector<const BVHNode*> stack;
+			if (m_root)
+			{
+				stack.push_back(m_root.get());
+			}
+			while (!stack.empty())
+			{
+				auto node = stack.back();
+				stack.pop_back();
+				++numof_nodes;
+				if (node->left)
+				{
+					stack.push_back(node->left.get());
+				}
+				if (node->right)
+				{
+					stack.push_back(node->right.get());
+				}
+			}
+
+			return numof_nodes * sizeof(BVHNode);
+		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "bvh_quality.h"
+#include "bvh.h"
+
+#include <glm/common.hpp>
+#include <algorithm>
+#include <utility>
+
+namespace glue
+{
+	namespace geometry
+	{
+		namespace
+		{
+			float getOverlapSurfaceArea(const BBox& a, const BBox& b)
+			{
+				auto min = glm::max(a.get_min(), b.get_min());
+				auto max = glm::min(a.get_max(), b.get_max());
+				if (max.x < min.x || max.y < min.y || max.z < min.z)
+				{
+					return 0.0f;
+				}
+
+				return BBox(min, max).getSurfaceArea();
+			}
+		}
+
+		BVHQuality analyzeBVH(const BVHNode* root)
+		{
+			BVHQuality quality;
+			if (!root)
+			{
+				return quality;
+			}
+
+			auto root_area = static_cast<double>(root->bbox.getSurfaceArea());
+			double interior_area_sum = 0.0;
+			double leaf_cost_sum = 0.0;
+			double overlap_sum = 0.0;
+
+			std::vector<std::pair<const BVHNode*, int>> stack{ { root, 0 } };
+			while (!stack.empty())
+			{
+				auto node = stack.back().first;
+				auto depth = stack.back().second;
+				stack.pop_back();
+				++quality.numof_nodes;
+
+				if (node->left)
+				{
+					interior_area_sum += node->bbox.getSurfaceArea();
+					auto parent_area = node->bbox.getSurfaceArea();
+					auto overlap = parent_area > 0.0f ? getOverlapSurfaceArea(node->left->bbox, node->right->bbox) / parent_area : 0.0f;
+					overlap_sum += overlap;
+					quality.max_sibling_overlap = std::max(quality.max_sibling_overlap, static_cast<double>(overlap));
+
+					stack.emplace_back(node->left.get(), depth + 1);
+					stack.emplace_back(node->right.get(), depth + 1);
+				}
+				else
+				{
+					auto size = node->end - node->start;
+					++quality.numof_leaves;
+					quality.numof_primitives += size;
+					quality.max_depth = std::max(quality.max_depth, depth);
+					quality.max_leaf_size = std::max(quality.max_leaf_size, size);
+					leaf_cost_sum += static_cast<double>(node->bbox.getSurfaceArea()) * size;
+
+					if (static_cast<int>(quality.depth_histogram.size()) <= depth)
+					{
+						quality.depth_histogram.resize(depth + 1);
+					}
+					++quality.depth_histogram[depth];
+					if (static_cast<int>(quality.leaf_size_histogram.size()) <= size)
+					{
+						quality.leaf_size_histogram.resize(size + 1);
+					}
+					++quality.leaf_size_histogram[size];
+				}
+			}
+
+			auto numof_interiors = quality.numof_nodes - quality.numof_leaves;
+			//Every interior node on the path leaves at most one sibling on the stack, and the leaf is pushed along with its own sibling.
+			quality.max_stack_size = quality.max_depth + 1;
+			quality.average_leaf_size = static_cast<double>(quality.numof_primitives) / quality.numof_leaves;
+			quality.average_sibling_overlap = numof_interiors > 0 ? overlap_sum / numof_interiors : 0.0;
+			//A flat root has no area to compare with, so every primitive counts as tested.
+			quality.sah_cost = root_area > 0.0 ? (interior_area_sum + leaf_cost_sum) / root_area : quality.numof_primitives;
+
+			return quality;
+		}
+	}
+}
\ No newline at end of file
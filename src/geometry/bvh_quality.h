@@ -0,0 +1,35 @@
+#ifndef __GLUE__GEOMETRY__BVHQUALITY__
+#define __GLUE__GEOMETRY__BVHQUALITY__
+
+#include <vector>
+
+namespace glue
+{
+	namespace geometry
+	{
+		struct BVHNode;
+
+		//Structural measures of a built tree, for comparing builders and catching degenerate trees.
+		struct BVHQuality
+		{
+			int numof_nodes = 0;
+			int numof_leaves = 0;
+			int numof_primitives = 0;
+			int max_depth = 0; //The root is at depth 0.
+			int max_stack_size = 0; //Entries the traversal needs in the worst case, to compare with cBVHStackSize.
+			int max_leaf_size = 0;
+			double average_leaf_size = 0.0;
+			//Expected cost of a random ray relative to the root, with the unit traversal and intersection costs the SAH builder uses.
+			double sah_cost = 0.0;
+			//Surface area of the overlap of two siblings over the surface area of their parent.
+			double average_sibling_overlap = 0.0;
+			double max_sibling_overlap = 0.0;
+			std::vector<int> depth_histogram; //Leaves at every depth.
+			std::vector<int> leaf_size_histogram; //Leaves with every primitive count.
+		};
+
+		BVHQuality analyzeBVH(const BVHNode* root);
+	}
+}
+
+#endif
\ No newline at end of file
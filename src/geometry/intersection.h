@@ -15,9 +15,10 @@ namespace glue
 		{
 			Plane plane;
 			glm::vec2 uv;
-			glm::vec3 dpdu;
-			glm::vec3 dpdv;
+			glm::vec3 dpdu{ 0.0f };
+			glm::vec3 dpdv{ 0.0f };
 			float distance{ -1.0f };
+			float footprint{ 0.0f }; //Width of the ray cone at the point. Textures are filtered over it, so 0 fetches their finest level.
 			int bsdf_choice{ -1 };
 			//Pointers will be kept as raw pointers.
 			//The reason is to prevent overhead due to shared_ptr destruction and construction
@@ -41,6 +41,11 @@ namespace glue
 			return values;
 		}
 
+		std::size_t UVMapper::getMemoryUsage() const
+		{
+			return sizeof(*this);
+		}
+
 		Mapper::Values SphericalMapper::map(const glm::vec3& cartesian, const glm::vec3& barycentric) const
 		{
 			Values values;
@@ -62,5 +67,10 @@ namespace glue
 
 			return values;
 		}
+
+		std::size_t SphericalMapper::getMemoryUsage() const
+		{
+			return sizeof(*this);
+		}
 	}
 }
\ No newline at end of file
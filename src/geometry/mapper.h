@@ -3,6 +3,7 @@
 
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
+#include <cstddef>
 
 namespace glue
 {
@@ -23,6 +24,7 @@ namespace glue
 
 			virtual Values map(const glm::vec3& cartesian, const glm::vec3& barycentric) const = 0;
 			virtual Values mapOnlyUV(const glm::vec3& cartesian, const glm::vec3& barycentric) const = 0;
+			virtual std::size_t getMemoryUsage() const = 0;
 		};
 
 		class UVMapper : public Mapper
@@ -32,6 +34,7 @@ namespace glue
 
 			Values map(const glm::vec3& cartesian, const glm::vec3& barycentric) const override;
 			Values mapOnlyUV(const glm::vec3& cartesian, const glm::vec3& barycentric) const override;
+			std::size_t getMemoryUsage() const override;
 
 		private:
 			glm::vec3 m_dpdu;
@@ -46,6 +49,7 @@ namespace glue
 		public:
 			Values map(const glm::vec3& cartesian, const glm::vec3& barycentric) const override;
 			Values mapOnlyUV(const glm::vec3& cartesian, const glm::vec3& barycentric) const override;
+			std::size_t getMemoryUsage() const override;
 		};
 	}
 }
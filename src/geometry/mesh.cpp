@@ -1,5 +1,6 @@
 #include "mesh.h"
 #include "triangle.h"
+#include "../core/memory.h"
 #include "../xml/parser.h"
 
 namespace glue
@@ -46,9 +47,11 @@ namespace glue
 				m_area += area;
 			}
 			m_triangle_sampler = core::Discrete1DSampler(triangle_areas);
+			//Instances of a model add up.
+			core::memory::add("Mesh samplers", xml.datapath, m_triangle_sampler.getMemoryUsage());
 		}
 
-		geometry::Plane Mesh::samplePlane(core::UniformSampler& sampler) const
+		geometry::Plane Mesh::samplePlane(core::RealSampler& sampler) const
 		{
 			return m_transformation.planeToWorldSpace(m_bvh->get_objects()[m_triangle_sampler.sample(sampler)].samplePlane(sampler));
 		}
@@ -33,7 +33,7 @@ namespace glue
 		public:
 			explicit Mesh(const Mesh::Xml& xml);
 
-			geometry::Plane samplePlane(core::UniformSampler& sampler) const override;
+			geometry::Plane samplePlane(core::RealSampler& sampler) const override;
 			float getSurfaceArea() const override;
 			BBox getBBox() const override;
 			glm::vec2 getBoundsOnAxis(int axis) const override;
@@ -29,7 +29,7 @@ namespace glue
 		public:
 			virtual ~Object() = default;
 
-			virtual geometry::Plane samplePlane(core::UniformSampler& sampler) const = 0;
+			virtual geometry::Plane samplePlane(core::RealSampler& sampler) const = 0;
 			virtual float getSurfaceArea() const = 0;
 			virtual BBox getBBox() const = 0;
 			virtual glm::vec2 getBoundsOnAxis(int axis) const = 0;
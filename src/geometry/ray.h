@@ -23,6 +23,16 @@ namespace glue
 			glm::vec3 m_origin;
 			glm::vec3 m_direction;
 		};
+
+		//Cone around a ray that bounds the footprint of a pixel, as in "Texture Level of Detail Strategies for Real-Time Ray Tracing"
+		//by Akenine-Moller et al. Integrators carry it along the path to pick mip levels of textures.
+		struct RayCone
+		{
+			float width; //At the origin of the ray.
+			float spread_angle; //In radians.
+
+			float getWidth(float distance) const { return width + spread_angle * distance; }
+		};
 	}
 }
 
@@ -50,9 +50,10 @@ namespace glue
 			m_area = 4.0f * glm::pi<float>() * t_radius * t_radius;
 		}
 
-		geometry::Plane Sphere::samplePlane(core::UniformSampler& sampler) const
+		geometry::Plane Sphere::samplePlane(core::RealSampler& sampler) const
 		{
-			auto point = core::math::sampleSphereUniform(sampler.sample(), sampler.sample()).toCartesianCoordinate();
+			auto u = sampler.get2D();
+			auto point = core::math::sampleSphereUniform(u.x, u.y).toCartesianCoordinate();
 
 			return m_transformation.planeToWorldSpace(Plane(point, point));
 		}
@@ -31,7 +31,7 @@ namespace glue
 		public:
 			explicit Sphere(const Sphere::Xml& xml);
 
-			geometry::Plane samplePlane(core::UniformSampler& sampler) const override;
+			geometry::Plane samplePlane(core::RealSampler& sampler) const override;
 			float getSurfaceArea() const override;
 			BBox getBBox() const override;
 			glm::vec2 getBoundsOnAxis(int axis) const override;
@@ -26,14 +26,15 @@ namespace glue
 			}
 		}
 
-		geometry::Plane Triangle::samplePlane(core::UniformSampler& sampler) const
+		geometry::Plane Triangle::samplePlane(core::RealSampler& sampler) const
 		{
 			auto v1 = m_edge1 + m_v0;
 			auto v2 = m_edge2 + m_v0;
 
-			auto sqrt_rand = glm::sqrt(sampler.sample());
+			auto rand = sampler.get2D();
+			auto sqrt_rand = glm::sqrt(rand.x);
 			auto u = 1.0f - sqrt_rand;
-			auto v = sampler.sample() * sqrt_rand;
+			auto v = rand.y * sqrt_rand;
 
 			return geometry::Plane(m_v0 * u + v1 * v + v2 * (1.0f - u - v), m_normal);
 		}
@@ -128,5 +129,10 @@ namespace glue
 			intersection.dpdu = values.dpdu;
 			intersection.dpdv = values.dpdv;
 		}
+
+		std::size_t Triangle::getMapperMemoryUsage() const
+		{
+			return m_mapper->getMemoryUsage();
+		}
 	}
 }
\ No newline at end of file
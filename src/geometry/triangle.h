@@ -25,7 +25,7 @@ namespace glue
 			Triangle(const glm::vec3& v0, const glm::vec3& edge1, const glm::vec3& edge2,
 				const glm::vec2& uv0, const glm::vec2& uv1, const glm::vec2& uv2);
 
-			geometry::Plane samplePlane(core::UniformSampler& sampler) const;
+			geometry::Plane samplePlane(core::RealSampler& sampler) const;
 			float getSurfaceArea() const;
 			BBox getBBox() const;
 			glm::vec2 getBoundsOnAxis(int axis) const;
@@ -33,6 +33,8 @@ namespace glue
 			bool intersect(const Ray& ray, Intersection& intersection, float max_distance) const;
 			bool intersectShadowRay(const Ray& ray, float max_distance) const;
 			void fillIntersection(const Ray& ray, Intersection& intersection) const;
+			//Mappers are allocated separately from the triangles.
+			std::size_t getMapperMemoryUsage() const;
 
 		private:
 			glm::vec3 m_v0;
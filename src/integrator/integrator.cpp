@@ -1,7 +1,12 @@
 #include "pathtracer.h"
 #include "sppm.h"
+#include "../geometry/intersection.h"
+#include "../geometry/ray.h"
+#include "../material/bsdf_material.h"
 #include "../xml/node.h"
 
+#include <glm/common.hpp>
+
 namespace glue
 {
 	namespace integrator
@@ -25,5 +30,18 @@ namespace glue
 
 			return nullptr;
 		}
+
+		geometry::RayCone Integrator::bounceRayCone(const geometry::RayCone& cone, const geometry::Intersection& intersection)
+		{
+			//About 6 degrees, the width of a glossy lobe.
+			constexpr float cRoughSpreadAngle = 0.1f;
+
+			if (intersection.bsdf_material->isSpecular(intersection))
+			{
+				return geometry::RayCone{ intersection.footprint, cone.spread_angle };
+			}
+
+			return geometry::RayCone{ intersection.footprint, glm::max(cone.spread_angle, cRoughSpreadAngle) };
+		}
 	}
 }
\ No newline at end of file
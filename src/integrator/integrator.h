@@ -4,7 +4,10 @@
 #include "../core/forward_decl.h"
 
 #include <glm/vec3.hpp>
+#include <istream>
 #include <memory>
+#include <ostream>
+#include <vector>
 
 namespace glue
 {
@@ -25,6 +28,21 @@ namespace glue
 			virtual ~Integrator() {}
 
 			virtual void integrate(const core::Scene& scene, core::Image& output) = 0;
+			//Writes the estimate of the whole image as of the last patch or pass that the integrator has published.
+			//It is called from another thread while integrate() is running, so it must never read the accumulators that the workers update.
+			virtual void getProgress(const core::Scene& scene, core::Image& output) const = 0;
+			//Checkpoints hold the accumulation state of the render so that it can be resumed by another process.
+			//They are only written at points where no worker is running.
+			virtual void saveCheckpoint(std::ostream& stream, const core::Image& output) const = 0;
+			virtual void loadCheckpoint(std::istream& stream, core::Image& output) = 0;
+			//Raw results of a distributed render part, indexed by y * width + x. Parts are merged by adding
+			//the weighted sums and the weights of the pixels. Pixels that are not rendered have zero weight.
+			virtual void getPartial(const core::Image& output, std::vector<glm::vec3>& weighted_sums, std::vector<float>& weights) const = 0;
+
+		protected:
+			//Ray cone of a ray scattered at the intersection, whose footprint is already set. Specular bounces keep the spread since
+			//the surfaces are treated as flat. Other bounces spread it at least as wide as a rough lobe, so indirect lookups use coarse levels.
+			static geometry::RayCone bounceRayCone(const geometry::RayCone& cone, const geometry::Intersection& intersection);
 		};
 	}
 }
@@ -1,12 +1,21 @@
 #include "pathtracer.h"
 #include "../geometry/intersection.h"
+#include "../geometry/ray.h"
 #include "../core/coordinate_space.h"
 #include "../core/scene.h"
 #include "../core/math.h"
+#include "../core/binary_io.h"
+#include "../core/cost_map.h"
+#include "../core/memory.h"
+#include "../core/stats.h"
+#include "../core/thread_pool.h"
+#include "../core/trace.h"
 #include "../material/bsdf_material.h"
 #include "../xml/node.h"
 
-#include <omp.h>
+#include <limits>
+#include <numeric>
+#include <string>
 
 namespace glue
 {
@@ -15,7 +24,11 @@ namespace glue
 		Pathtracer::Xml::Xml(const xml::Node& node)
 		{
 			filter = core::Filter::Xml::factory(node.child("Filter", true));
+			auto sampler_node = node.child("Sampler");
+			sampler = sampler_node ? core::Sampler::Xml::factory(sampler_node) : std::make_unique<core::IndependentSampler::Xml>();
 			node.parseChildText("SampleCount", &sample_count);
+			node.parseChildText("MaxSampleCount", &max_sample_count, 0);
+			node.parseChildText("ErrorThreshold", &error_threshold, 0.0f);
 			node.parseChildText("RRThreshold", &rr_threshold);
 		}
 
@@ -25,102 +38,287 @@ namespace glue
 		}
 
 		Pathtracer::Pathtracer(const Pathtracer::Xml& xml)
-			: m_uniform_samplers(std::thread::hardware_concurrency())
+			: m_sampler(xml.sampler->create())
 			, m_filter(xml.filter->create())
 			, m_sample_count(xml.sample_count)
+			, m_max_sample_count(xml.max_sample_count)
+			, m_pixel_sample_limit(0)
+			, m_resumed(false)
+			, m_error_threshold(xml.error_threshold)
 			, m_rr_threshold(xml.rr_threshold)
-		{
-			int numof_cores = std::thread::hardware_concurrency();
-			for (int i = 0; i < numof_cores; ++i)
-			{
-				m_offset_samplers.push_back(m_filter->generateSampler());
-			}
-		}
+		{}
 
 		void Pathtracer::integrate(const core::Scene& scene, core::Image& output)
 		{
 			auto resolution = scene.camera->get_resolution();
-			int x, y;
+			if (!m_resumed)
+			{
+				m_pixels.assign(resolution.x * resolution.y, PixelState());
+			}
+			{
+				std::lock_guard<std::mutex> lock(m_progress_mutex);
+				m_progress = std::make_unique<core::Image>(resolution.x, resolution.y);
+			}
+			//Samples loaded from a checkpoint show up in the intermediate images right away.
+			publishProgress(0, 0, resolution.x, resolution.y);
+			core::memory::set("Integrator", "Pathtracer pixels", m_pixels.capacity() * sizeof(PixelState));
+			core::memory::set("Integrator", "Pathtracer progress image", m_progress->getMemoryUsage());
+			//The pools live on the stacks of the workers.
+			core::memory::set("Integrator", "Pathtracer ray and intersection pools",
+				scene.thread_count * cPTPatchSize * cPTPatchSize * (sizeof(geometry::Ray) + sizeof(geometry::Intersection)));
+			m_resumed = false;
+
+			m_samplers.clear();
+			for (int i = 0; i < scene.thread_count; ++i)
+			{
+				m_samplers.push_back(m_sampler->clone());
+			}
 
-			#pragma omp parallel num_threads(std::thread::hardware_concurrency())
+			//Pixels stop at SampleCount unless adaptive sampling or a time limit lets them go further.
+			//A sample range of a distributed render fixes the count.
+			if (scene.job.sample_end > 0)
+			{
+				m_pixel_sample_limit = scene.job.getSampleCount(m_sample_count);
+			}
+			else if (m_max_sample_count > m_sample_count)
 			{
-				#pragma omp for schedule(dynamic) collapse(2)
-				for (x = 0; x < resolution.x; x += cPTPatchSize)
+				m_pixel_sample_limit = m_max_sample_count;
+			}
+			else
+			{
+				m_pixel_sample_limit = scene.hasTimeLimit() ? std::numeric_limits<int>::max() : m_sample_count;
+			}
+
+			//Every pass adds up to SampleCount samples to the active pixels of each patch.
+			//A pass is cut short when a checkpoint is due, which is then written while no worker is running.
+			std::vector<core::Tile> tiles;
+			for (const auto& origin : core::TileScheduler::orderTiles(resolution, cPTTileSize, scene.tile_order))
+			{
+				tiles.emplace_back(origin, cPTTileSize, 0);
+			}
+
+			int numof_patches_x = (resolution.x + cPTPatchSize - 1) / cPTPatchSize;
+			auto worker_nodes = scene.getWorkerNodes();
+			int numof_active = resolution.x * resolution.y;
+			while (numof_active > 0 && !scene.isStopRequested())
+			{
+				core::TileScheduler scheduler(tiles, resolution, cPTPatchSize, scene.thread_count, worker_nodes);
+
+				//One task per worker, each taking tiles from the scheduler until none is left.
+				//Every worker counts on its own cache line.
+				struct alignas(64) ActiveCount
+				{
+					int count = 0;
+				};
+				std::vector<ActiveCount> active_counts(scene.thread_count);
+				core::ThreadPool::get().parallelFor(0, scene.thread_count, 1, [&](int task, int id)
 				{
-					for (y = 0; y < resolution.y; y += cPTPatchSize)
+					core::Tile tile;
+					while (scheduler.next(id, tile))
 					{
-						integratePatch(scene, output, x, y, omp_get_thread_num());
+						auto end = glm::min(tile.origin + tile.size, resolution);
+						for (int y = tile.origin.y; y < end.y; y += cPTPatchSize)
+						{
+							for (int x = tile.origin.x; x < end.x; x += cPTPatchSize)
+							{
+								if (scene.job.isTileIncluded((y / cPTPatchSize) * numof_patches_x + x / cPTPatchSize))
+								{
+									active_counts[id].count += integratePatch(scene, x, y, id);
+								}
+							}
+						}
 					}
+				});
+				numof_active = std::accumulate(active_counts.begin(), active_counts.end(), 0, [](int sum, const ActiveCount& active_count)
+				{
+					return sum + active_count.count;
+				});
+
+				if (scene.isCheckpointDue())
+				{
+					scene.saveCheckpoint();
+				}
+			}
+
+			getProgress(scene, output);
+		}
+
+		void Pathtracer::getProgress(const core::Scene& scene, core::Image& output) const
+		{
+			std::lock_guard<std::mutex> lock(m_progress_mutex);
+			if (!m_progress)
+			{
+				return;
+			}
+
+			const auto& progress = *m_progress;
+			int width = progress.get_width();
+			for (int y = 0; y < progress.get_height(); ++y)
+			{
+				output.setRow(y, progress.get_float_pixels().subspan(y * width, width));
+			}
+		}
+
+		void Pathtracer::publishProgress(int x, int y, int width, int height)
+		{
+			auto resolution_x = m_progress->get_width();
+			std::vector<glm::vec3> row(width);
+			std::lock_guard<std::mutex> lock(m_progress_mutex);
+			for (int j = y; j < y + height; ++j)
+			{
+				for (int i = 0; i < width; ++i)
+				{
+					const auto& pixel = m_pixels[j * resolution_x + x + i];
+					row[i] = pixel.sample_count > 0 ? pixel.sum / static_cast<float>(pixel.sample_count) : glm::vec3(0.0f);
 				}
+				m_progress->setRow(j, row, x);
+			}
+		}
+
+		void Pathtracer::saveCheckpoint(std::ostream& stream, const core::Image& output) const
+		{
+			core::binary::writeVector(stream, std::vector<char>(cPTCheckpointTag.begin(), cPTCheckpointTag.end()));
+			core::binary::writeVector(stream, m_pixels);
+		}
+
+		void Pathtracer::loadCheckpoint(std::istream& stream, core::Image& output)
+		{
+			std::vector<char> tag;
+			core::binary::readVector(stream, tag);
+			if (std::string(tag.begin(), tag.end()) != cPTCheckpointTag)
+			{
+				throw std::runtime_error("Error: Checkpoint was not written by Pathtracer");
+			}
+
+			core::binary::readVector(stream, m_pixels);
+			if (m_pixels.size() != static_cast<std::size_t>(output.get_width() * output.get_height()))
+			{
+				throw std::runtime_error("Error: Checkpoint does not match the image size");
 			}
+			m_resumed = true;
 		}
 
-		void Pathtracer::integratePatch(const core::Scene& scene, core::Image& output, int x, int y, int id)
+		void Pathtracer::getPartial(const core::Image& output, std::vector<glm::vec3>& weighted_sums, std::vector<float>& weights) const
 		{
+			weighted_sums.clear();
+			weights.clear();
+			for (const auto& pixel : m_pixels)
+			{
+				weighted_sums.push_back(pixel.sum);
+				weights.push_back(static_cast<float>(pixel.sample_count));
+			}
+		}
+
+		int Pathtracer::integratePatch(const core::Scene& scene, int x, int y, int id)
+		{
+			core::trace::Scope scope("integratePatch");
 			auto resolution = scene.camera->get_resolution();
 			auto bound_x = glm::min(cPTPatchSize, resolution.x - x);
 			auto bound_y = glm::min(cPTPatchSize, resolution.y - y);
 
-			std::array<std::array<glm::vec3, cPTPatchSize>, cPTPatchSize> final_values;
 			std::array<std::array<geometry::Ray, cPTPatchSize>, cPTPatchSize> ray_pool;
 			std::array<std::array<geometry::Intersection, cPTPatchSize>, cPTPatchSize> intersection_pool;
+			auto& sampler = *m_samplers[id];
+			geometry::RayCone camera_cone{ 0.0f, scene.camera->getPixelSpreadAngle() };
 
-			for (int k = 0; k < m_sample_count; ++k)
+			for (int k = 0; k < m_sample_count && !scene.isStopRequested() && !scene.isCheckpointDue(); ++k)
 			{
-				for (int i = 0; i < bound_x; ++i)
+				for (int j = 0; j < bound_y; ++j)
 				{
-					for (int j = 0; j < bound_y; ++j)
+					for (int i = 0; i < bound_x; ++i)
 					{
-						ray_pool[i][j] = scene.camera->castRay(x + i, y + j, m_offset_samplers[id]->sample(), m_offset_samplers[id]->sample());
+						const auto& pixel = m_pixels[(y + j) * resolution.x + x + i];
+						if (pixel.active)
+						{
+							sampler.startPixelSample(glm::ivec2(x + i, y + j), scene.job.sample_begin + pixel.sample_count);
+							auto u = sampler.get2D();
+							ray_pool[j][i] = scene.camera->castRay(x + i, y + j, m_filter->sampleOffset(u.x), m_filter->sampleOffset(u.y));
+						}
 					}
 				}
 
-				for (int i = 0; i < bound_x; ++i)
+				for (int j = 0; j < bound_y; ++j)
 				{
-					for (int j = 0; j < bound_y; ++j)
+					for (int i = 0; i < bound_x; ++i)
 					{
-						intersection_pool[i][j] = geometry::Intersection();
-						scene.intersect(ray_pool[i][j], intersection_pool[i][j], std::numeric_limits<float>::max());
+						if (m_pixels[(y + j) * resolution.x + x + i].active)
+						{
+							core::CostMap::Probe probe(scene.cost_map.get());
+							intersection_pool[j][i] = geometry::Intersection();
+							scene.intersect(ray_pool[j][i], intersection_pool[j][i], std::numeric_limits<float>::max());
+							core::stats::add(core::stats::Counter::CAMERA_RAYS);
+							probe.finish(x + i, y + j, 0);
+						}
 					}
 				}
 
-				auto new_factor = 1.0f / (k + 1);
-				auto old_factor = k * new_factor;
-				for (int i = 0; i < bound_x; ++i)
+				for (int j = 0; j < bound_y; ++j)
 				{
-					for (int j = 0; j < bound_y; ++j)
+					for (int i = 0; i < bound_x; ++i)
 					{
-						auto& pixel_acc = final_values[i][j];
-						pixel_acc *= old_factor;
-						pixel_acc += new_factor * estimatePixel(scene, ray_pool[i][j], intersection_pool[i][j], m_uniform_samplers[id], 1.0f, false);
+						auto& pixel = m_pixels[(y + j) * resolution.x + x + i];
+						if (!pixel.active)
+						{
+							continue;
+						}
+
+						core::CostMap::Probe probe(scene.cost_map.get());
+						sampler.startPixelSample(glm::ivec2(x + i, y + j), scene.job.sample_begin + pixel.sample_count, core::cCameraSampleDimensions);
+						auto value = estimatePixel(scene, ray_pool[j][i], intersection_pool[j][i], camera_cone, sampler, 1.0f, false, 1);
+						probe.finish(x + i, y + j, 1);
+						pixel.sum += value;
+						auto sample_count = ++pixel.sample_count;
+
+						auto luminance = core::math::rgbToLuminance(value);
+						auto delta = luminance - pixel.luminance_mean;
+						pixel.luminance_mean += delta / sample_count;
+						pixel.luminance_m2 += delta * (luminance - pixel.luminance_mean);
+
+						if (sample_count >= m_pixel_sample_limit)
+						{
+							pixel.active = false;
+						}
+						//Standard error of the mean relative to the mean. Dark pixels are compared against a small floor instead.
+						else if (sample_count > 1 && sample_count >= m_sample_count)
+						{
+							auto variance_of_mean = pixel.luminance_m2 / ((sample_count - 1) * sample_count);
+							auto relative_error = glm::sqrt(variance_of_mean) / glm::max(pixel.luminance_mean, 1e-2f);
+							pixel.active = relative_error >= m_error_threshold;
+						}
 					}
 				}
 			}
 
-			for (int i = 0; i < bound_x; ++i)
+			int numof_active = 0;
+			for (int j = 0; j < bound_y; ++j)
 			{
-				for (int j = 0; j < bound_y; ++j)
+				for (int i = 0; i < bound_x; ++i)
 				{
-					output.set(x + i, y + j, final_values[i][j]);
+					numof_active += m_pixels[(y + j) * resolution.x + x + i].active;
 				}
 			}
+			publishProgress(x, y, bound_x, bound_y);
+
+			return numof_active;
 		}
 
-		glm::vec3 Pathtracer::estimatePixel(const core::Scene& scene, geometry::Ray& ray, geometry::Intersection& intersection,
-			core::UniformSampler& uniform_sampler, float importance, bool light_explicitly_sampled) const
+		glm::vec3 Pathtracer::estimatePixel(const core::Scene& scene, geometry::Ray& ray, geometry::Intersection& intersection, const geometry::RayCone& cone,
+			core::Sampler& sampler, float importance, bool light_explicitly_sampled, int depth) const
 		{
 			constexpr float cutoff_probability = 0.5f;
 			constexpr float calc_weight = 1.0f / (1.0f - cutoff_probability);
 
 			if (!intersection.object)
 			{
-				return scene.getBackgroundRadiance(ray.get_direction(), light_explicitly_sampled);
+				core::stats::addPathLength(depth);
+				return scene.getBackgroundRadiance(ray.get_direction(), light_explicitly_sampled, cone.spread_angle);
 			}
 
 			//Check if the ray hits a light source.
 			auto itr = scene.object_to_light.find(intersection.object);
 			if (itr != scene.object_to_light.end())
 			{
+				core::stats::addPathLength(depth);
 				if (!light_explicitly_sampled)
 				{
 					return itr->second->getLe(ray.get_direction(), intersection.plane.normal, intersection.distance);
@@ -131,10 +329,12 @@ namespace glue
 				}
 			}
 
+			sampler.startBounce(depth - 1);
+			intersection.footprint = cone.getWidth(intersection.distance);
 			core::CoordinateSpace tangent_space(intersection.plane.point, intersection.plane.normal, intersection.dpdu);
 			auto wo_tangent = tangent_space.vectorToLocalSpace(-ray.get_direction());
 
-			auto chosenbsdf_and_pdf = intersection.bsdf_material->chooseBsdf(wo_tangent, uniform_sampler, intersection);
+			auto chosenbsdf_and_pdf = intersection.bsdf_material->chooseBsdf(wo_tangent, sampler, intersection);
 			intersection.bsdf_choice = chosenbsdf_and_pdf.first;
 			auto chosenbsdf_pdf = chosenbsdf_and_pdf.second;
 
@@ -148,7 +348,7 @@ namespace glue
 				{
 					const auto* light = scene.lights[i].get();
 
-					auto light_sample = light->sample(uniform_sampler, intersection);
+					auto light_sample = light->sample(sampler, intersection);
 					auto wi_tangent_light = tangent_space.vectorToLocalSpace(light_sample.wi_world);
 
 					auto bsdf = intersection.bsdf_material->getBsdf(wi_tangent_light, wo_tangent, intersection);
@@ -180,7 +380,7 @@ namespace glue
 						}
 
 						//Generate a sample according to the bsdf.
-						auto w_f = intersection.bsdf_material->sampleWi(wo_tangent, uniform_sampler, intersection);
+						auto w_f = intersection.bsdf_material->sampleWi(wo_tangent, sampler, intersection);
 						const auto& wi_tangent_bsdf = w_f.first;
 
 						//Get the light sample through the sampled direction.
@@ -215,7 +415,7 @@ namespace glue
 			}
 
 			//INDIRECT LIGHTING//
-			auto w_f = intersection.bsdf_material->sampleWi(wo_tangent, uniform_sampler, intersection);
+			auto w_f = intersection.bsdf_material->sampleWi(wo_tangent, sampler, intersection);
 
 			const auto& wi_tangent = w_f.first;
 
@@ -230,15 +430,26 @@ namespace glue
 			{
 				//Russian roulette.
 				importance *= glm::min(1.0f, glm::max(glm::max(f.x, f.y), f.z));
-				if (importance > m_rr_threshold || uniform_sampler.sample() > cutoff_probability)
+				if (importance > m_rr_threshold || sampler.sample() > cutoff_probability)
 				{
 					auto wi_world = tangent_space.vectorToWorldSpace(wi_tangent);
 					ray = geometry::Ray(intersection.plane.point + wi_world * scene.secondary_ray_epsilon, wi_world);
+					auto next_cone = bounceRayCone(cone, intersection);
 
 					intersection = geometry::Intersection();
 					scene.intersect(ray, intersection, std::numeric_limits<float>::max());
-					indirect_lo = f * estimatePixel(scene, ray, intersection, uniform_sampler, importance, light_explicitly_sampled);
+					core::stats::add(core::stats::Counter::BOUNCE_RAYS);
+					indirect_lo = f * estimatePixel(scene, ray, intersection, next_cone, sampler, importance, light_explicitly_sampled, depth + 1);
 				}
+				else
+				{
+					core::stats::add(core::stats::Counter::RR_TERMINATIONS);
+					core::stats::addPathLength(depth);
+				}
+			}
+			else
+			{
+				core::stats::addPathLength(depth);
 			}
 
 			return direct_lo + (importance < m_rr_threshold ? indirect_lo * calc_weight : indirect_lo);
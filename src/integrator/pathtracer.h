@@ -3,8 +3,11 @@
 
 #include "integrator.h"
 #include "../core/filter.h"
+#include "../core/sampler.h"
 #include "../core/forward_decl.h"
 
+#include <mutex>
+#include <string_view>
 #include <vector>
 
 namespace glue
@@ -13,6 +16,22 @@ namespace glue
 	{
 		constexpr int cPTPatchSize = 16;
 
+		//Tiles start this large and are split down to patches when they are stolen.
+		constexpr int cPTTileSize = 4 * cPTPatchSize;
+
+		constexpr std::string_view cPTCheckpointTag = "Pathtracer";
+
+		//Accumulation state of a pixel.
+		struct PixelState
+		{
+			glm::vec3 sum = glm::vec3(0.0f);
+			int sample_count = 0;
+			//Welford estimates of the mean and the sum of squared differences of the sample luminances.
+			float luminance_mean = 0.0f;
+			float luminance_m2 = 0.0f;
+			bool active = true; //False once the pixel has converged or reached its sample limit.
+		};
+
 		class Pathtracer : public Integrator
 		{
 		public:
@@ -20,7 +39,10 @@ namespace glue
 			struct Xml : Integrator::Xml
 			{
 				std::unique_ptr<core::Filter::Xml> filter;
+				std::unique_ptr<core::Sampler::Xml> sampler;
 				int sample_count;
+				int max_sample_count; //Upper limit of adaptive sampling and time limited renders. Ignored if it does not exceed sample_count.
+				float error_threshold; //Relative error of the pixel mean below which a pixel stops being sampled.
 				float rr_threshold;
 
 				explicit Xml(const xml::Node& node);
@@ -31,18 +53,33 @@ namespace glue
 			explicit Pathtracer(const Pathtracer::Xml& xml);
 
 			void integrate(const core::Scene& scene, core::Image& output) override;
+			void getProgress(const core::Scene& scene, core::Image& output) const override;
+			void saveCheckpoint(std::ostream& stream, const core::Image& output) const override;
+			void loadCheckpoint(std::istream& stream, core::Image& output) override;
+			void getPartial(const core::Image& output, std::vector<glm::vec3>& weighted_sums, std::vector<float>& weights) const override;
 
 		private:
-			std::vector<std::unique_ptr<core::RealSampler>> m_offset_samplers;
-			std::vector<core::UniformSampler> m_uniform_samplers;
+			std::vector<PixelState> m_pixels; //Indexed by y * resolution.x + x.
+			std::unique_ptr<core::Image> m_progress; //Pixel means as of their last finished patch, the only state getProgress() reads.
+			mutable std::mutex m_progress_mutex; //Guards m_progress.
+			std::unique_ptr<core::Sampler> m_sampler; //Prototype of the per-thread samplers.
+			std::vector<std::unique_ptr<core::Sampler>> m_samplers;
 			std::unique_ptr<core::Filter> m_filter;
 			int m_sample_count;
+			int m_max_sample_count;
+			int m_pixel_sample_limit;
+			bool m_resumed; //True if m_pixels is loaded from a checkpoint.
+			float m_error_threshold;
 			float m_rr_threshold;
 
 		private:
-			void integratePatch(const core::Scene& scene, core::Image& output, int x, int y, int id);
-			glm::vec3 estimatePixel(const core::Scene& scene, geometry::Ray& ray, geometry::Intersection& intersection,
-				core::UniformSampler& uniform_sampler, float importance, bool light_explicitly_sampled) const;
+			//Returns the number of pixels in the patch that still need samples.
+			int integratePatch(const core::Scene& scene, int x, int y, int id);
+			//Writes the means of the pixels in the rectangle to m_progress. No worker may be sampling them meanwhile.
+			void publishProgress(int x, int y, int width, int height);
+			//depth is the number of segments of the path up to the intersection. cone is the ray cone of the ray.
+			glm::vec3 estimatePixel(const core::Scene& scene, geometry::Ray& ray, geometry::Intersection& intersection, const geometry::RayCone& cone,
+				core::Sampler& sampler, float importance, bool light_explicitly_sampled, int depth) const;
 		};
 	}
 }
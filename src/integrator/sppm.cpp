@@ -1,44 +1,70 @@
 #include "sppm.h"
 #include "../geometry/intersection.h"
+#include "../geometry/ray.h"
+#include "../core/coordinate_space.h"
 #include "../core/scene.h"
 #include "../core/math.h"
+#include "../core/timer.h"
+#include "../core/binary_io.h"
+#include "../core/cost_map.h"
+#include "../core/memory.h"
+#include "../core/stats.h"
+#include "../core/thread_pool.h"
+#include "../core/trace.h"
 #include "../material/bsdf_material.h"
 #include "../xml/node.h"
 
-#include <omp.h>
 #include <iostream>
+#include <algorithm>
+#include <numeric>
 
 namespace glue
 {
     namespace integrator
     {
-        HitPoint::HitPoint(const HitPoint& hp)
+        std::size_t HitPoints::getBytesPerHitPoint()
         {
-            *this = hp;
+            //Every hitpoint is referenced by at most cSPPMMaxCellsPerHitPoint cells of the grid, in addition to the two cell offset arrays.
+            return sizeof(glm::vec3) * 7 + sizeof(glm::vec2) + sizeof(float) * 3 + sizeof(const material::BsdfMaterial*) + sizeof(int) +
+                sizeof(int) * (cSPPMMaxCellsPerHitPoint + 2);
         }
 
-        HitPoint& HitPoint::operator = (const HitPoint& hp)
+        void HitPoints::assign(int size, float radius)
         {
-            tangent_space = hp.tangent_space;
-            wo_tangent = hp.wo_tangent;
-            direct_lo = hp.direct_lo;
-            unnormalized_flux = hp.unnormalized_flux;
-            beta = hp.beta;
-            intersection = hp.intersection;
-            acc_count = hp.acc_count;
-            curr_count = hp.curr_count;
-            radius = hp.radius;
-
-            return *this;
+            positions.assign(size, glm::vec3(0.0f));
+            radii.assign(size, radius);
+            normals.assign(size, glm::vec3(0.0f));
+            tangents.assign(size, glm::vec3(0.0f));
+            wo_tangents.assign(size, glm::vec3(0.0f));
+            betas.assign(size, glm::vec3(0.0f));
+            uvs.assign(size, glm::vec2(0.0f));
+            bsdf_materials.assign(size, nullptr);
+            bsdf_choices.assign(size, -1);
+            direct_los.assign(size, glm::vec3(0.0f));
+            unnormalized_fluxes.assign(size, glm::vec3(0.0f));
+            acc_counts.assign(size, 0.0f);
+            curr_counts.assign(size, 0.0f);
+        }
+
+        std::size_t HitPoints::getMemoryUsage() const
+        {
+            return positions.capacity() * sizeof(glm::vec3) + radii.capacity() * sizeof(float) + normals.capacity() * sizeof(glm::vec3) +
+                tangents.capacity() * sizeof(glm::vec3) + wo_tangents.capacity() * sizeof(glm::vec3) + betas.capacity() * sizeof(glm::vec3) +
+                uvs.capacity() * sizeof(glm::vec2) + bsdf_materials.capacity() * sizeof(const material::BsdfMaterial*) +
+                bsdf_choices.capacity() * sizeof(int) + direct_los.capacity() * sizeof(glm::vec3) + unnormalized_fluxes.capacity() * sizeof(glm::vec3) +
+                acc_counts.capacity() * sizeof(float) + curr_counts.capacity() * sizeof(float);
         }
 
         SPPM::Xml::Xml(const xml::Node& node)
         {
             filter = core::Filter::Xml::factory(node.child("Filter", true));
+            auto sampler_node = node.child("Sampler");
+            sampler = sampler_node ? core::Sampler::Xml::factory(sampler_node) : std::make_unique<core::IndependentSampler::Xml>();
             node.parseChildText("SampleCount", &sample_count);
             node.parseChildText("PhotonsPerPass", &photons_per_pass);
             node.parseChildText("RRThreshold", &rr_threshold);
             node.parseChildText("Alpha", &alpha);
+            node.parseChildText("MemoryBudget", &memory_budget, 0.0f);
         }
 
         std::unique_ptr<Integrator> SPPM::Xml::create() const
@@ -47,145 +73,562 @@ namespace glue
         }
 
         SPPM::SPPM(const SPPM::Xml& xml)
-            : m_uniform_samplers(std::thread::hardware_concurrency())
+            : m_grid_cell_width(0.0f)
+            , m_grid_levels(1)
+            , m_completed_passes(0)
+            , m_pass_count(0)
+            , m_tiles_per_group(0)
+            , m_group_start(0)
+            , m_resumed(false)
+            , m_sampler(xml.sampler->create())
             , m_filter(xml.filter->create())
             , m_max_search_radius(0.0f)
             , m_sample_count(xml.sample_count)
             , m_photons_per_pass(xml.photons_per_pass)
             , m_rr_threshold(xml.rr_threshold)
             , m_alpha(xml.alpha)
+            , m_memory_budget(xml.memory_budget)
+        {}
+
+        void SPPM::integrate(const core::Scene& scene, core::Image& output)
+        {
+            auto resolution = scene.camera->get_resolution();
+
+            //Photons are distributed among the lights in proportion to their power.
+            if (scene.lights.empty())
+            {
+                throw std::runtime_error("Error: SPPM requires at least one light");
+            }
+            std::vector<float> light_powers;
+            for (const auto& light : scene.lights)
+            {
+                light_powers.push_back(core::math::rgbToLuminance(light->getFlux(scene)));
+            }
+            m_light_sampler = core::Discrete1DSampler(light_powers);
+
+            m_samplers.clear();
+            for (int i = 0; i < scene.thread_count; ++i)
+            {
+                m_samplers.push_back(m_sampler->clone());
+            }
+            m_photon_deposits.resize(scene.thread_count);
+            //The pools live on the stacks of the workers.
+            core::memory::set("Integrator", "SPPM ray and intersection pools",
+                scene.thread_count * cSPPMPatchSize * cSPPMPatchSize * (sizeof(geometry::Ray) + sizeof(geometry::Intersection)));
+
+            //Tiles follow the tile order of the scene so that every tile group covers a compact region of the image.
+            //Tiles that belong to other parts of a distributed render are skipped. They are identified row by row.
+            int numof_tiles_x = (resolution.x + cSPPMPatchSize - 1) / cSPPMPatchSize;
+            std::vector<glm::ivec2> tiles;
+            for (const auto& tile : core::TileScheduler::orderTiles(resolution, cSPPMPatchSize, scene.tile_order))
+            {
+                if (scene.job.isTileIncluded((tile.y / cSPPMPatchSize) * numof_tiles_x + tile.x / cSPPMPatchSize))
+                {
+                    tiles.push_back(tile);
+                }
+            }
+            m_pixel_weights.resize(resolution.x * resolution.y, 0.0f);
+            {
+                //Pixels of the tile groups finished before a checkpoint are already in the output.
+                std::lock_guard<std::mutex> lock(m_progress_mutex);
+                m_progress = std::make_unique<core::Image>(output);
+            }
+            core::memory::set("Integrator", "SPPM progress image", m_progress->getMemoryUsage());
+            m_pass_count = scene.job.getSampleCount(m_sample_count);
+
+            //Tiles are rendered in groups whose hitpoints fit into the memory budget.
+            //Every group runs all of the passes by itself while photons are still shot into the whole scene.
+            int numof_tiles = tiles.size();
+            int tiles_per_group = numof_tiles;
+            if (m_memory_budget > 0.0f)
+            {
+                auto bytes_per_tile = HitPoints::getBytesPerHitPoint() * cSPPMPatchSize * cSPPMPatchSize;
+                auto budget_in_bytes = static_cast<double>(m_memory_budget) * 1024.0 * 1024.0;
+                tiles_per_group = glm::clamp(static_cast<int>(budget_in_bytes / bytes_per_tile), 1, numof_tiles);
+            }
+
+            //A resumed render continues from the tile group and the pass of the checkpoint.
+            auto first_group_start = 0;
+            if (m_resumed)
+            {
+                if (m_tiles_per_group != tiles_per_group)
+                {
+                    throw std::runtime_error("Error: Checkpoint was written with another MemoryBudget");
+                }
+                first_group_start = m_group_start;
+            }
+            m_tiles_per_group = tiles_per_group;
+
+            for (int i = first_group_start; i < numof_tiles && !scene.isStopRequested(); i += tiles_per_group)
+            {
+                m_tiles.assign(tiles.begin() + i, tiles.begin() + glm::min(i + tiles_per_group, numof_tiles));
+                m_group_start = i;
+                if (!m_resumed)
+                {
+                    m_completed_passes = 0;
+                }
+                m_resumed = false;
+                //Remaining time is shared equally among the remaining groups.
+                auto numof_groups_left = (numof_tiles - i + tiles_per_group - 1) / tiles_per_group;
+                integrateTiles(scene, output, scene.getRemainingTime() / numof_groups_left);
+
+                if (tiles_per_group < numof_tiles)
+                {
+                    std::cout << "Tiles done: " << i + static_cast<int>(m_tiles.size()) << "/" << numof_tiles << std::endl;
+                }
+            }
+        }
+
+        void SPPM::getProgress(const core::Scene& scene, core::Image& output) const
         {
-            int numof_cores = std::thread::hardware_concurrency();
-            for (int i = 0; i < numof_cores; ++i)
+            std::lock_guard<std::mutex> lock(m_progress_mutex);
+            if (!m_progress)
+            {
+                return;
+            }
+
+            const auto& progress = *m_progress;
+            int width = progress.get_width();
+            for (int y = 0; y < progress.get_height(); ++y)
             {
-                m_offset_samplers.push_back(m_filter->generateSampler());
+                output.setRow(y, progress.get_float_pixels().subspan(y * width, width));
             }
         }
 
-        void SPPM::integrate(const core::Scene& scene, core::Image& output)
+        void SPPM::saveCheckpoint(std::ostream& stream, const core::Image& output) const
         {
-            int numof_cores = std::thread::hardware_concurrency();
+            core::binary::writeVector(stream, std::vector<char>(cSPPMCheckpointTag.begin(), cSPPMCheckpointTag.end()));
+            core::binary::write(stream, m_tiles_per_group);
+            core::binary::write(stream, m_group_start);
+            core::binary::write(stream, m_completed_passes.load());
+            core::binary::write(stream, m_max_search_radius);
+            //Only the per-pixel state that survives between passes is needed. The rest is rebuilt by the next camera pass.
+            core::binary::writeVector(stream, m_hitpoints.radii);
+            core::binary::writeVector(stream, m_hitpoints.direct_los);
+            core::binary::writeVector(stream, m_hitpoints.unnormalized_fluxes);
+            core::binary::writeVector(stream, m_hitpoints.acc_counts);
+            core::binary::writeVector(stream, m_pixel_weights);
+
+            //Pixels of the finished tile groups.
+            int width = output.get_width();
+            std::vector<glm::vec3> pixels(width * output.get_height());
+            for (int y = 0; y < output.get_height(); ++y)
+            {
+                output.getRow(y, core::Span<glm::vec3>(pixels.data() + y * width, width));
+            }
+            core::binary::writeVector(stream, pixels);
+        }
+
+        void SPPM::loadCheckpoint(std::istream& stream, core::Image& output)
+        {
+            std::vector<char> tag;
+            core::binary::readVector(stream, tag);
+            if (std::string(tag.begin(), tag.end()) != cSPPMCheckpointTag)
+            {
+                throw std::runtime_error("Error: Checkpoint was not written by SPPM");
+            }
+
+            int completed_passes;
+            core::binary::read(stream, m_tiles_per_group);
+            core::binary::read(stream, m_group_start);
+            core::binary::read(stream, completed_passes);
+            core::binary::read(stream, m_max_search_radius);
+            m_completed_passes = completed_passes;
+
+            std::vector<float> radii;
+            core::binary::readVector(stream, radii);
+            m_hitpoints.assign(radii.size(), 0.0f);
+            m_hitpoints.radii = std::move(radii);
+            core::binary::readVector(stream, m_hitpoints.direct_los);
+            core::binary::readVector(stream, m_hitpoints.unnormalized_fluxes);
+            core::binary::readVector(stream, m_hitpoints.acc_counts);
+            core::binary::readVector(stream, m_pixel_weights);
+            auto numof_hitpoints = m_hitpoints.radii.size();
+            if (m_hitpoints.direct_los.size() != numof_hitpoints || m_hitpoints.unnormalized_fluxes.size() != numof_hitpoints ||
+                m_hitpoints.acc_counts.size() != numof_hitpoints)
+            {
+                throw std::runtime_error("Error: Checkpoint is corrupted");
+            }
+            if (m_pixel_weights.size() != static_cast<std::size_t>(output.get_width() * output.get_height()))
+            {
+                throw std::runtime_error("Error: Checkpoint does not match the image size");
+            }
+
+            std::vector<glm::vec3> pixels;
+            core::binary::readVector(stream, pixels);
+            if (pixels.size() != m_pixel_weights.size())
+            {
+                throw std::runtime_error("Error: Checkpoint does not match the image size");
+            }
+            int width = output.get_width();
+            for (int y = 0; y < output.get_height(); ++y)
+            {
+                output.setRow(y, core::Span<const glm::vec3>(pixels.data() + y * width, width));
+            }
+            m_resumed = true;
+        }
+
+        void SPPM::integrateTiles(const core::Scene& scene, core::Image& output, double time_limit)
+        {
+            core::Timer timer;
+            int numof_cores = scene.thread_count;
             auto resolution = scene.camera->get_resolution();
-            m_intersection_pool.resize(resolution.x, std::vector<geometry::Intersection>(resolution.y));
-            m_hitpoint_pool.resize(resolution.x, std::vector<HitPoint>(resolution.y));
+            const auto& tiles = m_tiles;
+            //Every tile owns a block of cSPPMPatchSize * cSPPMPatchSize hitpoints.
+            constexpr int cHitPointsPerTile = cSPPMPatchSize * cSPPMPatchSize;
+            int numof_tiles = tiles.size();
+            int numof_hitpoints = numof_tiles * cHitPointsPerTile;
+            m_grid_cell_starts.assign(numof_hitpoints + 1, 0);
+            m_grid_cell_cursors = std::vector<std::atomic<int>>(numof_hitpoints + 1);
+
+            //Hitpoints of a group resumed from a checkpoint are already initialized.
+            int first_pass = m_completed_passes;
+            if (first_pass == 0)
+            {
+                //Initial estimation for maximum search radius.
+                auto scene_bbox = scene.getBBox();
+                auto volume_per_pixel = scene_bbox.get_max().x * scene_bbox.get_max().y * scene_bbox.get_max().z / (resolution.x * resolution.y);
+                m_max_search_radius = glm::pow(volume_per_pixel, 0.33333f) * 2.0f;
 
-            //Initial estimation for maximum search radius.
-            auto scene_bbox = scene.getBBox();
-            auto volume_per_pixel = scene_bbox.get_max().x * scene_bbox.get_max().y * scene_bbox.get_max().z / (resolution.x * resolution.y);
-            m_max_search_radius = glm::pow(volume_per_pixel, 0.33333f) * 2.0f;
-            //std::cout << m_max_search_radius << std::endl;
+                //Initialize hitpoints.
+                m_hitpoints.assign(numof_hitpoints, m_max_search_radius);
+            }
+            else if (static_cast<int>(m_hitpoints.radii.size()) != numof_hitpoints)
+            {
+                throw std::runtime_error("Error: Checkpoint does not match the tile group");
+            }
+            else
+            {
+                publishProgress(scene);
+            }
+            core::memory::set("Integrator", "SPPM hitpoints", m_hitpoints.getMemoryUsage());
 
-            //Initialize hitpoints.
-            for (int i = 0; i < resolution.x; ++i)
+            //Loops over the hitpoints are split into chunks large enough to amortize the scheduling.
+            constexpr int cHitPointChunkSize = 4096;
+            constexpr int cPhotonChunkSize = 64;
+            //Reductions are accumulated per worker. Every worker gets its own cache line.
+            struct alignas(64) WorkerState
             {
-                for (int j = 0; j < resolution.y; ++j)
+                std::vector<int> buckets;
+                float radius_sum;
+                float max_radius;
+                int numof_visible;
+                float max_search_radius;
+            };
+            std::vector<WorkerState> worker_states(numof_cores);
+            auto& pool = core::ThreadPool::get();
+
+            //With a time limit, passes continue until the time share of the group runs out instead of SampleCount.
+            bool stop = !scene.hasTimeLimit() && first_pass >= m_pass_count;
+            for (int k = first_pass; !stop; ++k)
+            {
+                for (auto& deposits : m_photon_deposits)
                 {
-                    auto& hitpoint = m_hitpoint_pool[i][j];
-                    hitpoint.radius = m_max_search_radius;
-                    hitpoint.intersection = &m_intersection_pool[i][j];
+                    deposits.clear();
+                }
+                for (auto& state : worker_states)
+                {
+                    state.radius_sum = 0.0f;
+                    state.max_radius = 0.0f;
+                    state.numof_visible = 0;
+                    state.max_search_radius = -std::numeric_limits<float>::max();
                 }
-            }
 
-            float new_max_search_radius;
-            #pragma omp parallel num_threads(numof_cores)
-            {
-                for (int k = 0; k < m_sample_count; ++k)
                 {
-                    #pragma omp single
+                    core::stats::ScopedPhase phase("SPPM hitpoints");
+                    pool.parallelFor(0, numof_tiles, 1, [&](int t, int worker)
                     {
-                        new_max_search_radius = -std::numeric_limits<float>::max();
-                        m_grids.clear();
-                        m_grids.resize(numof_cores);
-                    }
+                        findHitPoints(scene, tiles[t].x, tiles[t].y, t * cHitPointsPerTile, scene.job.sample_begin + k, worker);
+                    });
+                }
 
-                    #pragma omp for schedule(dynamic) collapse(2)
-                    for (int x = 0; x < resolution.x; x += cSPPMPatchSize)
+                //Build the grid.
+                {
+                    core::stats::ScopedPhase phase("SPPM grid");
+                    pool.parallelFor(0, numof_hitpoints, cHitPointChunkSize, [&](int i, int worker)
                     {
-                        for (int y = 0; y < resolution.y; y += cSPPMPatchSize)
+                        if (m_hitpoints.bsdf_materials[i])
                         {
-                            findHitPoints(scene, x, y, omp_get_thread_num());
+                            worker_states[worker].radius_sum += m_hitpoints.radii[i];
+                            worker_states[worker].max_radius = glm::max(worker_states[worker].max_radius, m_hitpoints.radii[i]);
+                            ++worker_states[worker].numof_visible;
                         }
+                    });
+                    auto radius_sum = 0.0f;
+                    auto max_radius = 0.0f;
+                    auto numof_visible = 0;
+                    for (const auto& state : worker_states)
+                    {
+                        radius_sum += state.radius_sum;
+                        max_radius = glm::max(max_radius, state.max_radius);
+                        numof_visible += state.numof_visible;
                     }
 
-                    #pragma omp for schedule(dynamic)
-                    for (int p = 0; p < m_photons_per_pass; ++p)
+                    //Cells of the first level are as wide as the mean hitpoint diameter. Further levels are added until the largest hitpoint fits into 2 cells along each axis.
+                    m_grid_cell_width = numof_visible > 0 ? 2.0f * radius_sum / numof_visible : 2.0f * m_max_search_radius;
+                    m_grid_levels = 1;
+                    while (m_grid_levels < cSPPMMaxGridLevels && m_grid_cell_width * (1 << (m_grid_levels - 1)) < 2.0f * max_radius)
                     {
-                        tracePhoton(scene, omp_get_thread_num(), 0.5f / m_max_search_radius);
+                        ++m_grid_levels;
                     }
 
-                    #pragma omp for schedule(dynamic) collapse(2) reduction(max: new_max_search_radius)
-                    for (int x = 0; x < resolution.x; x += cSPPMPatchSize)
+                    //The counts and the prefix sum over them are split into chunks of cells.
+                    int numof_cells = numof_hitpoints + 1;
+                    int numof_cell_chunks = (numof_cells + cHitPointChunkSize - 1) / cHitPointChunkSize;
+                    std::vector<int> cell_chunk_offsets(numof_cell_chunks + 1, 0);
+                    pool.parallelFor(0, numof_cell_chunks, 1, [&](int c, int worker)
                     {
-                        for (int y = 0; y < resolution.y; y += cSPPMPatchSize)
+                        for (int i = c * cHitPointChunkSize; i < glm::min((c + 1) * cHitPointChunkSize, numof_cells); ++i)
                         {
-                            auto patch_max_search_radius = update(scene, x, y);
-                            new_max_search_radius = glm::max(new_max_search_radius, patch_max_search_radius);
+                            m_grid_cell_cursors[i].store(0, std::memory_order_relaxed);
                         }
+                    });
+
+                    //Count the hitpoints falling into each hashed cell.
+                    pool.parallelFor(0, numof_hitpoints, cHitPointChunkSize, [&](int i, int worker)
+                    {
+                        if (m_hitpoints.bsdf_materials[i])
+                        {
+                            auto& buckets = worker_states[worker].buckets;
+                            getGridBuckets(i, buckets);
+                            for (auto bucket : buckets)
+                            {
+                                m_grid_cell_cursors[bucket + 1].fetch_add(1, std::memory_order_relaxed);
+                            }
+                        }
+                    });
+
+                    //Prefix sum of the counts. Every chunk is summed on its own, then offset by the total of the chunks before it.
+                    pool.parallelFor(0, numof_cell_chunks, 1, [&](int c, int worker)
+                    {
+                        auto sum = 0;
+                        for (int i = c * cHitPointChunkSize; i < glm::min((c + 1) * cHitPointChunkSize, numof_cells); ++i)
+                        {
+                            sum += m_grid_cell_cursors[i].load(std::memory_order_relaxed);
+                            m_grid_cell_starts[i] = sum;
+                        }
+                        cell_chunk_offsets[c + 1] = sum;
+                    });
+                    std::partial_sum(cell_chunk_offsets.begin(), cell_chunk_offsets.end(), cell_chunk_offsets.begin());
+                    pool.parallelFor(0, numof_cell_chunks, 1, [&](int c, int worker)
+                    {
+                        for (int i = c * cHitPointChunkSize; i < glm::min((c + 1) * cHitPointChunkSize, numof_cells); ++i)
+                        {
+                            m_grid_cell_starts[i] += cell_chunk_offsets[c];
+                            m_grid_cell_cursors[i].store(m_grid_cell_starts[i], std::memory_order_relaxed);
+                        }
+                    });
+                    m_grid_hitpoints.resize(m_grid_cell_starts.back());
+                    core::memory::set("Integrator", "SPPM grid", (m_grid_cell_starts.capacity() + m_grid_hitpoints.capacity()) * sizeof(int) +
+                        m_grid_cell_cursors.capacity() * sizeof(std::atomic<int>));
+
+                    //Scatter the hitpoints into their cell ranges.
+                    pool.parallelFor(0, numof_hitpoints, cHitPointChunkSize, [&](int i, int worker)
+                    {
+                        if (m_hitpoints.bsdf_materials[i])
+                        {
+                            auto& buckets = worker_states[worker].buckets;
+                            getGridBuckets(i, buckets);
+                            for (auto bucket : buckets)
+                            {
+                                m_grid_hitpoints[m_grid_cell_cursors[bucket].fetch_add(1, std::memory_order_relaxed)] = i;
+                            }
+                        }
+                    });
+                }
+
+                {
+                    core::stats::ScopedPhase phase("SPPM photons");
+                    //Chunks are handed out by hand so that each of them is a single event of the trace instead of one per photon.
+                    int numof_photon_chunks = (m_photons_per_pass + cPhotonChunkSize - 1) / cPhotonChunkSize;
+                    //Photon indices of long and distributed renders do not fit into an int.
+                    auto first_photon = (static_cast<std::uint64_t>(scene.job.sample_begin) + k) * m_photons_per_pass;
+                    pool.parallelFor(0, numof_photon_chunks, 1, [&](int c, int worker)
+                    {
+                        core::trace::Scope scope("tracePhoton");
+                        for (int p = c * cPhotonChunkSize; p < glm::min((c + 1) * cPhotonChunkSize, m_photons_per_pass); ++p)
+                        {
+                            tracePhoton(scene, first_photon + p, worker);
+                        }
+                    });
+
+                    std::size_t deposit_bytes = 0;
+                    for (const auto& deposits : m_photon_deposits)
+                    {
+                        deposit_bytes += deposits.capacity() * sizeof(PhotonDeposit);
                     }
+                    core::memory::set("Integrator", "SPPM photon deposits", deposit_bytes);
+                }
 
-                    #pragma omp single
+                //Merge the photon deposits into the hitpoints without any locking.
+                //Each buffer is first sorted by hitpoint, then every chunk of hitpoints is owned by a single worker.
+                {
+                    core::stats::ScopedPhase phase("SPPM merge");
+                    pool.parallelFor(0, numof_cores, 1, [&](int t, int worker)
                     {
-                        m_max_search_radius = new_max_search_radius;
-                        std::cout << m_max_search_radius << std::endl;
+                        compactPhotonDeposits(m_photon_deposits[t]);
+                    });
+
+                    int numof_merge_chunks = (numof_hitpoints + cSPPMMergeChunkSize - 1) / cSPPMMergeChunkSize;
+                    pool.parallelFor(0, numof_merge_chunks, 1, [&](int c, int worker)
+                    {
+                        int i = c * cSPPMMergeChunkSize;
+                        mergePhotonDeposits(i, glm::min(i + cSPPMMergeChunkSize, numof_hitpoints));
+                    });
+                }
+
+                {
+                    core::stats::ScopedPhase phase("SPPM update");
+                    pool.parallelFor(0, numof_tiles, 1, [&](int t, int worker)
+                    {
+                        auto patch_max_search_radius = update(scene, tiles[t].x, tiles[t].y, t * cHitPointsPerTile);
+                        worker_states[worker].max_search_radius = glm::max(worker_states[worker].max_search_radius, patch_max_search_radius);
+                    });
+                }
+
+                m_max_search_radius = -std::numeric_limits<float>::max();
+                for (const auto& state : worker_states)
+                {
+                    m_max_search_radius = glm::max(m_max_search_radius, state.max_search_radius);
+                }
+                m_completed_passes = k + 1;
+                publishProgress(scene);
+
+                if (scene.isCheckpointDue())
+                {
+                    scene.saveCheckpoint();
+                }
+
+                stop = scene.isStopRequested() || (scene.hasTimeLimit() ? timer.getTime() >= time_limit : k + 1 >= m_pass_count);
+            }
+
+            writeTiles(scene, output);
+
+            //Weights of the finished pixels for merging distributed renders.
+            for (const auto& tile : tiles)
+            {
+                for (int j = tile.y; j < glm::min(tile.y + cSPPMPatchSize, resolution.y); ++j)
+                {
+                    for (int i = tile.x; i < glm::min(tile.x + cSPPMPatchSize, resolution.x); ++i)
+                    {
+                        m_pixel_weights[j * resolution.x + i] = static_cast<float>(m_completed_passes);
                     }
                 }
             }
+        }
 
-            //Write final values to output.
-            for (int i = 0; i < resolution.x; ++i)
+        void SPPM::getPartial(const core::Image& output, std::vector<glm::vec3>& weighted_sums, std::vector<float>& weights) const
+        {
+            int width = output.get_width();
+            weights = m_pixel_weights;
+            weighted_sums.resize(width * output.get_height());
+            for (int y = 0; y < output.get_height(); ++y)
             {
-                for (int j = 0; j < resolution.y; ++j)
+                core::Span<glm::vec3> row(weighted_sums.data() + y * width, width);
+                output.getRow(y, row);
+                for (int x = 0; x < width; ++x)
                 {
-                    auto& hitpoint = m_hitpoint_pool[i][j];
+                    row[x] *= weights[y * width + x];
+                }
+            }
+        }
 
-                    auto radiance = hitpoint.direct_lo / static_cast<float>(m_sample_count);
-                    radiance += hitpoint.unnormalized_flux /
-                            (m_sample_count * m_photons_per_pass * glm::pi<float>() * hitpoint.radius * hitpoint.radius);
-                    output.set(i, j, radiance);
+        void SPPM::writeTiles(const core::Scene& scene, core::Image& output) const
+        {
+            int numof_passes = m_completed_passes;
+            if (numof_passes == 0)
+            {
+                return;
+            }
+
+            auto resolution = scene.camera->get_resolution();
+            int numof_tiles = m_tiles.size();
+            for (int t = 0; t < numof_tiles; ++t)
+            {
+                auto bound_x = glm::min(cSPPMPatchSize, resolution.x - m_tiles[t].x);
+                auto bound_y = glm::min(cSPPMPatchSize, resolution.y - m_tiles[t].y);
+
+                std::array<glm::vec3, cSPPMPatchSize> row;
+                for (int j = 0; j < bound_y; ++j)
+                {
+                    for (int i = 0; i < bound_x; ++i)
+                    {
+                        auto index = t * cSPPMPatchSize * cSPPMPatchSize + j * cSPPMPatchSize + i;
+                        auto radius = m_hitpoints.radii[index];
+
+                        row[i] = m_hitpoints.direct_los[index] / static_cast<float>(numof_passes);
+                        row[i] += m_hitpoints.unnormalized_fluxes[index] /
+                                (numof_passes * m_photons_per_pass * glm::pi<float>() * radius * radius);
+                    }
+                    output.setRow(m_tiles[t].y + j, core::Span<const glm::vec3>(row.data(), bound_x), m_tiles[t].x);
                 }
             }
         }
 
-        void SPPM::findHitPoints(const core::Scene& scene, int x, int y, int id)
+        void SPPM::publishProgress(const core::Scene& scene)
+        {
+            std::lock_guard<std::mutex> lock(m_progress_mutex);
+            writeTiles(scene, *m_progress);
+        }
+
+        void SPPM::findHitPoints(const core::Scene& scene, int x, int y, int offset, int pass, int id)
         {
+            core::trace::Scope scope("findHitPoints");
             auto resolution = scene.camera->get_resolution();
             auto bound_x = glm::min(cSPPMPatchSize, resolution.x - x);
             auto bound_y = glm::min(cSPPMPatchSize, resolution.y - y);
 
             std::array<std::array<geometry::Ray, cSPPMPatchSize>, cSPPMPatchSize> ray_pool;
+            std::array<std::array<geometry::Intersection, cSPPMPatchSize>, cSPPMPatchSize> intersection_pool;
+            auto& sampler = *m_samplers[id];
 
-            for (int i = 0; i < bound_x; ++i)
+            for (int j = 0; j < bound_y; ++j)
             {
-                for (int j = 0; j < bound_y; ++j)
+                for (int i = 0; i < bound_x; ++i)
                 {
-                    ray_pool[i][j] = scene.camera->castRay(x + i, y + j, m_offset_samplers[id]->sample(), m_offset_samplers[id]->sample());
+                    sampler.startPixelSample(glm::ivec2(x + i, y + j), pass);
+                    auto u = sampler.get2D();
+                    ray_pool[j][i] = scene.camera->castRay(x + i, y + j, m_filter->sampleOffset(u.x), m_filter->sampleOffset(u.y));
                 }
             }
 
-            for (int i = 0; i < bound_x; ++i)
+            for (int j = 0; j < bound_y; ++j)
             {
-                for (int j = 0; j < bound_y; ++j)
+                for (int i = 0; i < bound_x; ++i)
                 {
-                    m_intersection_pool[x + i][y + j] = geometry::Intersection();
-                    scene.intersect(ray_pool[i][j], m_intersection_pool[x + i][y + j], std::numeric_limits<float>::max());
+                    core::CostMap::Probe probe(scene.cost_map.get());
+                    intersection_pool[j][i] = geometry::Intersection();
+                    scene.intersect(ray_pool[j][i], intersection_pool[j][i], std::numeric_limits<float>::max());
+                    core::stats::add(core::stats::Counter::CAMERA_RAYS);
+                    probe.finish(x + i, y + j, 0);
                 }
             }
 
-            for (int i = 0; i < bound_x; ++i)
+            for (int j = 0; j < bound_y; ++j)
             {
-                for (int j = 0; j < bound_y; ++j)
+                for (int i = 0; i < bound_x; ++i)
                 {
-                    estimateDirect(scene, ray_pool[i][j], x + i, y + j, id);
+                    core::CostMap::Probe probe(scene.cost_map.get());
+                    sampler.startPixelSample(glm::ivec2(x + i, y + j), pass, core::cCameraSampleDimensions);
+                    estimateDirect(scene, ray_pool[j][i], intersection_pool[j][i], offset + j * cSPPMPatchSize + i, id);
+                    probe.finish(x + i, y + j, 1);
                 }
             }
         }
 
-        void SPPM::tracePhoton(const core::Scene& scene, int id, float one_over_width)
+        void SPPM::tracePhoton(const core::Scene& scene, std::uint64_t photon_index, int id)
         {
-            auto& uniform_sampler = m_uniform_samplers[id];
-            const auto* light = scene.lights[0].get(); //TODO: Use an index. Not 0.
-
-            auto photon = light->castPhoton(uniform_sampler);
+            auto& sampler = *m_samplers[id];
+            //Photon paths use pixels outside of the image so that they are not correlated with camera paths.
+            //Sample indices have 32 bits, so every 2^32 photons move on to the next pixel.
+            sampler.startPixelSample(glm::ivec2(-1, -1 - static_cast<int>(photon_index >> 32)), static_cast<std::uint32_t>(photon_index));
+            auto& deposits = m_photon_deposits[id];
+            auto light_index = m_light_sampler.sample(sampler);
+            auto light_pdf = m_light_sampler.getPdf(light_index);
+            const auto* light = scene.lights[light_index].get();
+
+            auto photon = light->castPhoton(scene, sampler);
+            photon.beta /= light_pdf;
             //This is needed since the origin should be moved a little to avoid self collision.
             photon.ray = geometry::Ray(photon.ray.get_origin() + photon.ray.get_direction() * scene.secondary_ray_epsilon, photon.ray.get_direction());
             
@@ -194,49 +637,63 @@ namespace glue
                 geometry::Intersection intersection;
                 intersection.radiance_transport = false;
                 auto result = scene.intersect(photon.ray, intersection, std::numeric_limits<float>::max());
+                core::stats::add(core::stats::Counter::PHOTON_RAYS);
                 if (!result || !intersection.bsdf_material)
                 {
                     break;
                 }
 
+                //Bounce 0 is left to the emission of the photon.
+                sampler.startBounce(iteration + 1);
                 core::CoordinateSpace tangent_space(intersection.plane.point, intersection.plane.normal, intersection.dpdu);
                 auto wo_tangent = tangent_space.vectorToLocalSpace(-photon.ray.get_direction());
 
                 //Do not account for direct lighting and contribute to nearby non-specular hitpoints.
                 if (iteration > 0 && !intersection.bsdf_material->isSpecular(intersection))
                 {
-                    GridCell cell(static_cast<int>(std::floor(intersection.plane.point.x * one_over_width)),
-                            static_cast<int>(std::floor(intersection.plane.point.y * one_over_width)),
-                            static_cast<int>(std::floor(intersection.plane.point.z * one_over_width)));
+                    //The cell of the photon is looked up on every level. Cells of different levels may be hashed to the same bucket, which must be scanned only once.
+                    int buckets[cSPPMMaxGridLevels];
+                    int numof_buckets = 0;
+                    for (int level = 0; level < m_grid_levels; ++level)
+                    {
+                        auto cell_width = m_grid_cell_width * (1 << level);
+                        auto bucket = hashGridCell(glm::ivec3(glm::floor(intersection.plane.point / cell_width)), level);
+                        if (std::find(buckets, buckets + numof_buckets, bucket) == buckets + numof_buckets)
+                        {
+                            buckets[numof_buckets++] = bucket;
+                        }
+                    }
 
-                    for (const auto& grid : m_grids)
+                    for (int b = 0; b < numof_buckets; ++b)
                     {
-                        auto found = grid.find(cell);
-                        if (found != grid.end())
+                        auto bucket_end = m_grid_cell_starts[buckets[b] + 1];
+                        for (int i = m_grid_cell_starts[buckets[b]]; i < bucket_end; ++i)
                         {
-                            for (const auto hitpoint : found->second)
+                            auto index = m_grid_hitpoints[i];
+                            auto diff = m_hitpoints.positions[index] - intersection.plane.point;
+                            auto radius = m_hitpoints.radii[index];
+                            if (glm::dot(diff, diff) < radius * radius)
                             {
-                                auto diff = hitpoint->intersection->plane.point - intersection.plane.point;
-                                if (glm::dot(diff, diff) < hitpoint->radius * hitpoint->radius)
-                                {
-                                    auto wi_tangent = hitpoint->tangent_space.vectorToLocalSpace(-photon.ray.get_direction());
-                                    auto flux_contribution = photon.beta * hitpoint->beta *
-                                            hitpoint->intersection->bsdf_material->getBsdf(wi_tangent, hitpoint->wo_tangent, *hitpoint->intersection);
+                                const auto& normal = m_hitpoints.normals[index];
+                                const auto& tangent = m_hitpoints.tangents[index];
+                                auto wi_world = -photon.ray.get_direction();
+                                glm::vec3 wi_tangent(glm::dot(wi_world, tangent), glm::dot(wi_world, glm::cross(normal, tangent)), glm::dot(wi_world, normal));
 
-                                    std::lock_guard<std::mutex> lock(hitpoint->lock);
-                                    hitpoint->curr_count += 1.0f;
-                                    hitpoint->unnormalized_flux += flux_contribution;
-                                }
+                                auto hitpoint_intersection = getHitPointIntersection(index);
+                                auto flux_contribution = photon.beta * m_hitpoints.betas[index] *
+                                        hitpoint_intersection.bsdf_material->getBsdf(wi_tangent, m_hitpoints.wo_tangents[index], hitpoint_intersection);
+
+                                deposits.emplace_back(index, 1.0f, flux_contribution);
                             }
                         }
                     }
                 }
 
-                auto chosenbsdf_and_pdf = intersection.bsdf_material->chooseBsdf(wo_tangent, uniform_sampler, intersection);
+                auto chosenbsdf_and_pdf = intersection.bsdf_material->chooseBsdf(wo_tangent, sampler, intersection);
                 intersection.bsdf_choice = chosenbsdf_and_pdf.first;
                 auto chosenbsdf_pdf = chosenbsdf_and_pdf.second;
 
-                auto w_f = intersection.bsdf_material->sampleWi(wo_tangent, uniform_sampler, intersection);
+                auto w_f = intersection.bsdf_material->sampleWi(wo_tangent, sampler, intersection);
                 const auto& wi_tangent = w_f.first;
 
                 //Russian roulette.
@@ -247,8 +704,13 @@ namespace glue
                 photon.beta /= q;
 
                 auto beta_sum = photon.beta.x + photon.beta.y + photon.beta.z;
-                if (!std::isfinite(beta_sum) || beta_sum <= 0.0f || uniform_sampler.sample() > q)
+                if (!std::isfinite(beta_sum) || beta_sum <= 0.0f)
+                {
+                    break;
+                }
+                if (sampler.sample() > q)
                 {
+                    core::stats::add(core::stats::Counter::RR_TERMINATIONS);
                     break;
                 }
 
@@ -256,8 +718,9 @@ namespace glue
                 constexpr float calc_weight = 1.0f / (1.0f - cutoff_probability);
                 if (iteration > 8)
                 {
-                    if (uniform_sampler.sample() < cutoff_probability)
+                    if (sampler.sample() < cutoff_probability)
                     {
+                        core::stats::add(core::stats::Counter::RR_TERMINATIONS);
                         break;
                     }
                     else
@@ -271,54 +734,61 @@ namespace glue
             }
         }
 
-        float SPPM::update(const core::Scene& scene, int x, int y)
+        float SPPM::update(const core::Scene& scene, int x, int y, int offset)
         {
+            core::trace::Scope scope("update");
             auto resolution = scene.camera->get_resolution();
             auto bound_x = glm::min(cSPPMPatchSize, resolution.x - x);
             auto bound_y = glm::min(cSPPMPatchSize, resolution.y - y);
 
             auto max_search_radius = -std::numeric_limits<float>::max();
-            for (int i = 0; i < bound_x; ++i)
+            for (int j = 0; j < bound_y; ++j)
             {
-                for (int j = 0; j < bound_y; ++j)
+                for (int i = 0; i < bound_x; ++i)
                 {
-                    auto& hitpoint = m_hitpoint_pool[x + i][y + j];
+                    auto index = offset + j * cSPPMPatchSize + i;
+                    auto& acc_count = m_hitpoints.acc_counts[index];
+                    auto& curr_count = m_hitpoints.curr_counts[index];
+                    auto& radius = m_hitpoints.radii[index];
 
-                    if (hitpoint.intersection->bsdf_material)
+                    if (m_hitpoints.bsdf_materials[index])
                     {
-                        auto new_acc_count = hitpoint.acc_count + m_alpha * hitpoint.curr_count;
-                        auto radius_ratios_sqr = new_acc_count / (hitpoint.acc_count + hitpoint.curr_count);
-                        hitpoint.acc_count = new_acc_count;
+                        auto new_acc_count = acc_count + m_alpha * curr_count;
+                        auto radius_ratios_sqr = new_acc_count / (acc_count + curr_count);
+                        acc_count = new_acc_count;
 
                         if (std::isfinite(radius_ratios_sqr))
                         {
-                            hitpoint.radius *= glm::sqrt(radius_ratios_sqr);
-                            hitpoint.unnormalized_flux *= radius_ratios_sqr;
+                            radius *= glm::sqrt(radius_ratios_sqr);
+                            m_hitpoints.unnormalized_fluxes[index] *= radius_ratios_sqr;
                         }
 
-                        max_search_radius = glm::max(max_search_radius, hitpoint.radius);
+                        max_search_radius = glm::max(max_search_radius, radius);
                     }
 
-                    hitpoint.curr_count = 0.0f;
+                    curr_count = 0.0f;
                 }
             }
 
             return max_search_radius;
         }
 
-        void SPPM::estimateDirect(const core::Scene& scene, geometry::Ray& ray, int x, int y, int id)
+        void SPPM::estimateDirect(const core::Scene& scene, geometry::Ray& ray, geometry::Intersection& intersection, int index, int id)
         {
             glm::vec3 beta(1.0f);
             bool light_explicitly_sampled = false;
-            auto& uniform_sampler = m_uniform_samplers[id];
-            auto& intersection = m_intersection_pool[x][y];
-            auto& hitpoint = m_hitpoint_pool[x][y];
+            int depth = 1;
+            auto& sampler = *m_samplers[id];
+            auto& direct_lo_acc = m_hitpoints.direct_los[index];
+            m_hitpoints.bsdf_materials[index] = nullptr;
+            geometry::RayCone cone{ 0.0f, scene.camera->getPixelSpreadAngle() };
 
             while (true)
             {
                 if (!intersection.object)
                 {
-                    hitpoint.direct_lo += beta * scene.getBackgroundRadiance(ray.get_direction(), light_explicitly_sampled);
+                    direct_lo_acc += beta * scene.getBackgroundRadiance(ray.get_direction(), light_explicitly_sampled, cone.spread_angle);
+                    core::stats::addPathLength(depth);
                     break;
                 }
 
@@ -328,15 +798,18 @@ namespace glue
                 {
                     if (!light_explicitly_sampled)
                     {
-                        hitpoint.direct_lo += beta * itr->second->getLe(ray.get_direction(), intersection.plane.normal, intersection.distance);
+                        direct_lo_acc += beta * itr->second->getLe(ray.get_direction(), intersection.plane.normal, intersection.distance);
                     }
+                    core::stats::addPathLength(depth);
                     break;
                 }
 
+                sampler.startBounce(depth - 1);
+                intersection.footprint = cone.getWidth(intersection.distance);
                 core::CoordinateSpace tangent_space(intersection.plane.point, intersection.plane.normal, intersection.dpdu);
                 auto wo_tangent = tangent_space.vectorToLocalSpace(-ray.get_direction());
 
-                auto chosenbsdf_and_pdf = intersection.bsdf_material->chooseBsdf(wo_tangent, uniform_sampler, intersection);
+                auto chosenbsdf_and_pdf = intersection.bsdf_material->chooseBsdf(wo_tangent, sampler, intersection);
                 intersection.bsdf_choice = chosenbsdf_and_pdf.first;
                 auto chosenbsdf_pdf = chosenbsdf_and_pdf.second;
                 beta /= chosenbsdf_pdf;
@@ -351,7 +824,7 @@ namespace glue
                     {
                         const auto* light = scene.lights[i].get();
 
-                        auto light_sample = light->sample(uniform_sampler, intersection);
+                        auto light_sample = light->sample(sampler, intersection);
                         auto wi_tangent_light = tangent_space.vectorToLocalSpace(light_sample.wi_world);
 
                         auto bsdf = intersection.bsdf_material->getBsdf(wi_tangent_light, wo_tangent, intersection);
@@ -383,7 +856,7 @@ namespace glue
                             }
 
                             //Generate a sample according to the bsdf.
-                            auto w_f = intersection.bsdf_material->sampleWi(wo_tangent, uniform_sampler, intersection);
+                            auto w_f = intersection.bsdf_material->sampleWi(wo_tangent, sampler, intersection);
                             const auto& wi_tangent_bsdf = w_f.first;
 
                             //Get the light sample through the sampled direction.
@@ -417,39 +890,26 @@ namespace glue
                     light_explicitly_sampled = false;
                 }
 
-                hitpoint.direct_lo += beta * direct_lo;
+                direct_lo_acc += beta * direct_lo;
 
-                //Stop here and add the hitpoint to grid structure to be contributed by photons.
+                //Stop here and mark the hitpoint to be added to grid structure to be contributed by photons.
                 if (!intersection.bsdf_material->isSpecular(intersection))
                 {
-                    //Add hitpoint to grid structure.
-                    hitpoint.tangent_space = tangent_space;
-                    hitpoint.wo_tangent = wo_tangent;
-                    hitpoint.beta = beta;
-
-                    auto one_over_width = 0.5f / m_max_search_radius;
-                    auto radius_over_width = hitpoint.radius * one_over_width;
-
-                    glm::vec3 scaled_cell = intersection.plane.point * one_over_width;
-                    glm::ivec3 scaled_cell_start = glm::floor(scaled_cell - radius_over_width);
-                    glm::ivec3 scaled_cell_end = glm::floor(scaled_cell + radius_over_width);
-
-                    for (int i = scaled_cell_start.x; i <= scaled_cell_end.x; ++i)
-                    {
-                        for (int j = scaled_cell_start.y; j <= scaled_cell_end.y; ++j)
-                        {
-                            for (int k = scaled_cell_start.z; k <= scaled_cell_end.z; ++k)
-                            {
-                                m_grids[id][GridCell(i, j, k)].push_back(&hitpoint);
-                            }
-                        }
-                    }
+                    m_hitpoints.positions[index] = intersection.plane.point;
+                    m_hitpoints.normals[index] = tangent_space.vectorToWorldSpace(glm::vec3(0.0f, 0.0f, 1.0f));
+                    m_hitpoints.tangents[index] = tangent_space.vectorToWorldSpace(glm::vec3(1.0f, 0.0f, 0.0f));
+                    m_hitpoints.wo_tangents[index] = wo_tangent;
+                    m_hitpoints.betas[index] = beta;
+                    m_hitpoints.uvs[index] = intersection.uv;
+                    m_hitpoints.bsdf_materials[index] = intersection.bsdf_material;
+                    m_hitpoints.bsdf_choices[index] = intersection.bsdf_choice;
+                    core::stats::addPathLength(depth);
 
                     break;
                 }
 
                 //INDIRECT LIGHTING//
-                auto w_f = intersection.bsdf_material->sampleWi(wo_tangent, uniform_sampler, intersection);
+                auto w_f = intersection.bsdf_material->sampleWi(wo_tangent, sampler, intersection);
 
                 const auto& wi_tangent = w_f.first;
                 const auto& f = w_f.second;
@@ -459,16 +919,122 @@ namespace glue
                 {
                     auto wi_world = tangent_space.vectorToWorldSpace(wi_tangent);
                     ray = geometry::Ray(intersection.plane.point + wi_world * scene.secondary_ray_epsilon, wi_world);
+                    cone = bounceRayCone(cone, intersection);
 
                     intersection = geometry::Intersection();
                     scene.intersect(ray, intersection, std::numeric_limits<float>::max());
+                    core::stats::add(core::stats::Counter::BOUNCE_RAYS);
                     beta *= f;
+                    ++depth;
                 }
                 else
                 {
+                    core::stats::addPathLength(depth);
                     break;
                 }
             }
         }
+
+        void SPPM::compactPhotonDeposits(std::vector<PhotonDeposit>& deposits) const
+        {
+            std::sort(deposits.begin(), deposits.end(), [](const PhotonDeposit& a, const PhotonDeposit& b)
+            {
+                return a.hitpoint < b.hitpoint;
+            });
+
+            //Sum up the deposits of the same hitpoint so that hot hitpoints cost only one entry per thread.
+            int size = deposits.size();
+            int compact_size = 0;
+            for (int i = 0; i < size; ++i)
+            {
+                if (compact_size > 0 && deposits[compact_size - 1].hitpoint == deposits[i].hitpoint)
+                {
+                    deposits[compact_size - 1].count += deposits[i].count;
+                    deposits[compact_size - 1].flux += deposits[i].flux;
+                }
+                else
+                {
+                    deposits[compact_size++] = deposits[i];
+                }
+            }
+            deposits.resize(compact_size);
+        }
+
+        void SPPM::mergePhotonDeposits(int start, int end)
+        {
+            for (const auto& deposits : m_photon_deposits)
+            {
+                auto itr = std::lower_bound(deposits.begin(), deposits.end(), start, [](const PhotonDeposit& deposit, int hitpoint)
+                {
+                    return deposit.hitpoint < hitpoint;
+                });
+
+                for (; itr != deposits.end() && itr->hitpoint < end; ++itr)
+                {
+                    m_hitpoints.curr_counts[itr->hitpoint] += itr->count;
+                    m_hitpoints.unnormalized_fluxes[itr->hitpoint] += itr->flux;
+                }
+            }
+        }
+
+        geometry::Intersection SPPM::getHitPointIntersection(int index) const
+        {
+            //Materials only need the surface point, shading normal, texture coordinates and the chosen bsdf.
+            geometry::Intersection intersection;
+            intersection.plane = geometry::Plane(m_hitpoints.positions[index], m_hitpoints.normals[index]);
+            intersection.uv = m_hitpoints.uvs[index];
+            intersection.bsdf_choice = m_hitpoints.bsdf_choices[index];
+            intersection.bsdf_material = m_hitpoints.bsdf_materials[index];
+
+            return intersection;
+        }
+
+        void SPPM::getGridBuckets(int index, std::vector<int>& buckets) const
+        {
+            const auto& point = m_hitpoints.positions[index];
+            auto radius = m_hitpoints.radii[index];
+
+            //The hitpoint goes into the first level where it overlaps at most 2 cells along each axis.
+            int level = 0;
+            glm::ivec3 cell_start;
+            glm::ivec3 cell_end;
+            for (; ; ++level)
+            {
+                auto cell_width = m_grid_cell_width * (1 << level);
+                cell_start = glm::floor((point - radius) / cell_width);
+                cell_end = glm::floor((point + radius) / cell_width);
+                auto cell_count = cell_end - cell_start + 1;
+                if ((cell_count.x <= 2 && cell_count.y <= 2 && cell_count.z <= 2) || level == m_grid_levels - 1)
+                {
+                    break;
+                }
+            }
+            //Cells of the last level are at least as wide as the largest diameter, so a third cell along an axis can only come from rounding.
+            cell_end = glm::min(cell_end, cell_start + 1);
+
+            buckets.clear();
+            for (int i = cell_start.x; i <= cell_end.x; ++i)
+            {
+                for (int j = cell_start.y; j <= cell_end.y; ++j)
+                {
+                    for (int k = cell_start.z; k <= cell_end.z; ++k)
+                    {
+                        buckets.push_back(hashGridCell(glm::ivec3(i, j, k), level));
+                    }
+                }
+            }
+
+            //Different cells may be hashed to the same bucket. A hitpoint must not be contributed twice by the same photon.
+            std::sort(buckets.begin(), buckets.end());
+            buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+        }
+
+        int SPPM::hashGridCell(const glm::ivec3& cell, int level) const
+        {
+            //From "Optimized Spatial Hashing for Collision Detection of Deformable Objects" by Teschner et al. The level is hashed like a fourth coordinate.
+            auto hash = (static_cast<unsigned int>(cell.x) * 73856093u) ^ (static_cast<unsigned int>(cell.y) * 19349663u) ^ (static_cast<unsigned int>(cell.z) * 83492791u) ^
+                (static_cast<unsigned int>(level) * 2654435761u);
+            return static_cast<int>(hash % (m_grid_cell_starts.size() - 1));
+        }
     }
 }
\ No newline at end of file
@@ -3,13 +3,17 @@
 
 #include "integrator.h"
 #include "../core/filter.h"
+#include "../core/sampler.h"
 #include "../core/forward_decl.h"
-#include "../geometry/plane.h"
-#include "../core/coordinate_space.h"
+#include "../core/discrete_1d_sampler.h"
 
-#include <vector>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <atomic>
+#include <cstdint>
 #include <mutex>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
 
 namespace glue
 {
@@ -17,52 +21,53 @@ namespace glue
     {
         constexpr int cSPPMPatchSize = 16;
 
-        struct GridCell
-        {
-            int x, y, z;
+        constexpr int cSPPMMergeChunkSize = 1024;
 
-            GridCell()=default;
-            GridCell(int p_x, int p_y, int p_z)
-                : x(p_x)
-                , y(p_y)
-                , z(p_z)
-            {}
+        //Grid cells are sized so that a hitpoint never overlaps more cells than this.
+        constexpr int cSPPMMaxCellsPerHitPoint = 8;
 
-            bool operator == (const GridCell& gc) const
-            {
-                return x == gc.x && y == gc.y && z == gc.z;
-            }
-        };
+        //Each level of the grid has cells twice as wide as the previous one.
+        constexpr int cSPPMMaxGridLevels = 16;
+
+        constexpr std::string_view cSPPMCheckpointTag = "SPPM";
 
-        struct GridCellHash
+        //Hitpoints are kept as a structure of arrays that only stores what the photon pass needs.
+        //Photon lookups touch only positions and radii until a hitpoint is found to be within the radius.
+        struct HitPoints
         {
-            std::size_t operator()(const GridCell& gc) const
-            {
-                //https://stackoverflow.com/a/17017281/5091304
-                std::size_t res = 17;
-                res = res * 31 + std::hash<int>()(gc.x);
-                res = res * 31 + std::hash<int>()(gc.y);
-                res = res * 31 + std::hash<int>()(gc.z);
-                return res;
-            }
+            std::vector<glm::vec3> positions;
+            std::vector<float> radii; //Radius of contribution.
+            std::vector<glm::vec3> normals; //z axis of the shading frame.
+            std::vector<glm::vec3> tangents; //x axis of the shading frame.
+            std::vector<glm::vec3> wo_tangents; //Outgoing direction of "rendering equation", that is, inverse of camera ray.
+            std::vector<glm::vec3> betas;
+            std::vector<glm::vec2> uvs;
+            //nullptr if the camera path did not end on a non-specular surface in the current pass.
+            std::vector<const material::BsdfMaterial*> bsdf_materials;
+            std::vector<int> bsdf_choices;
+            std::vector<glm::vec3> direct_los;
+            std::vector<glm::vec3> unnormalized_fluxes; //Accumulation of photon contributions. Will be normalized in the end.
+            std::vector<float> acc_counts; //Total amount of photons contributing to the hitpoint.
+            std::vector<float> curr_counts; //Amount of photons contributing to the hitpoint in the current pass.
+
+            void assign(int size, float radius);
+            std::size_t getMemoryUsage() const;
+            static std::size_t getBytesPerHitPoint();
         };
 
-        struct HitPoint
+        //Photon contributions are buffered per thread and merged into the hitpoints after the photon pass.
+        struct PhotonDeposit
         {
-            HitPoint()=default;
-            HitPoint(const HitPoint& hp);
-            HitPoint& operator = (const HitPoint& hp);
-
-            std::mutex lock;
-            core::CoordinateSpace tangent_space;
-            glm::vec3 wo_tangent; //Outgoing direction of "rendering equation", that is, inverse of camera ray.
-            glm::vec3 direct_lo{ 0.0f, 0.0f, 0.0f };
-            glm::vec3 unnormalized_flux{ 0.0f, 0.0f, 0.0f }; //Accumulation of photon contributions. Will be normalized in the end.
-            glm::vec3 beta;
-            const geometry::Intersection* intersection{ nullptr };
-            float acc_count{ 0.0f }; //Total amount of photons contributing to the hitpoint.
-            float curr_count{ 0.0f }; //Amount of photons contributing to the hitpoint in the current pass.
-            float radius; //Radius of contribution.
+            int hitpoint; //Index of the hitpoint in the pool.
+            float count;
+            glm::vec3 flux;
+
+            PhotonDeposit()=default;
+            PhotonDeposit(int p_hitpoint, float p_count, const glm::vec3& p_flux)
+                : hitpoint(p_hitpoint)
+                , count(p_count)
+                , flux(p_flux)
+            {}
         };
 
         class SPPM : public Integrator
@@ -72,10 +77,12 @@ namespace glue
             struct Xml : Integrator::Xml
             {
                 std::unique_ptr<core::Filter::Xml> filter;
+                std::unique_ptr<core::Sampler::Xml> sampler;
                 int sample_count;
                 int photons_per_pass;
                 float rr_threshold;
                 float alpha;
+                float memory_budget; //In megabytes. If it is not positive, all of the image is rendered at once.
 
                 explicit Xml(const xml::Node& node);
                 std::unique_ptr<Integrator> create() const override;
@@ -85,26 +92,58 @@ namespace glue
             explicit SPPM(const SPPM::Xml& xml);
 
             void integrate(const core::Scene& scene, core::Image& output) override;
+            void getProgress(const core::Scene& scene, core::Image& output) const override;
+            void saveCheckpoint(std::ostream& stream, const core::Image& output) const override;
+            void loadCheckpoint(std::istream& stream, core::Image& output) override;
+            void getPartial(const core::Image& output, std::vector<glm::vec3>& weighted_sums, std::vector<float>& weights) const override;
 
         private:
-            std::vector<std::unordered_map<GridCell, std::vector<HitPoint*>, GridCellHash>> m_grids;
-            std::vector<std::vector<geometry::Intersection>> m_intersection_pool;
-            std::vector<std::vector<HitPoint>> m_hitpoint_pool;
-            std::vector<std::unique_ptr<core::RealSampler>> m_offset_samplers;
-            std::vector<core::UniformSampler> m_uniform_samplers;
+            //Spatial hash grid over the visible hitpoints. It is rebuilt in every pass with a parallel counting sort.
+            //Cells of the first level are as wide as the mean hitpoint diameter. A hitpoint goes into the first level where it overlaps at most 2 cells along each axis,
+            //so a few large hitpoints do not make every cell large. Cells of all levels share the same hashed buckets.
+            //Hitpoints of the i'th hashed cell are m_grid_hitpoints[m_grid_cell_starts[i]] ... m_grid_hitpoints[m_grid_cell_starts[i + 1] - 1].
+            std::vector<int> m_grid_cell_starts;
+            std::vector<std::atomic<int>> m_grid_cell_cursors; //Hitpoint counts of the cells, then the insertion cursors while the grid is filled.
+            std::vector<int> m_grid_hitpoints;
+            float m_grid_cell_width; //Width of the cells of the first level.
+            int m_grid_levels;
+            std::vector<std::vector<PhotonDeposit>> m_photon_deposits;
+            HitPoints m_hitpoints; //Every tile of the current tile group owns a contiguous block of hitpoints, stored row by row.
+            std::vector<glm::ivec2> m_tiles; //Tiles of the current tile group.
+            std::atomic<int> m_completed_passes; //Passes done on the current tile group.
+            int m_pass_count; //Passes to do on each tile group if there is no time limit.
+            std::vector<float> m_pixel_weights; //Passes done on the finished pixels, indexed by y * resolution.x + x.
+            std::unique_ptr<core::Image> m_progress; //Image as of the last finished pass, the only state getProgress() reads.
+            mutable std::mutex m_progress_mutex; //Guards m_progress.
+            int m_tiles_per_group;
+            int m_group_start; //Index of the first tile of the current tile group.
+            bool m_resumed; //True if the state of the current tile group is loaded from a checkpoint.
+            std::unique_ptr<core::Sampler> m_sampler; //Prototype of the per-thread samplers.
+            std::vector<std::unique_ptr<core::Sampler>> m_samplers;
             std::unique_ptr<core::Filter> m_filter;
+            core::Discrete1DSampler m_light_sampler; //Chooses the light to emit a photon from in proportion to its power.
             float m_max_search_radius;
 
             int m_sample_count;
             int m_photons_per_pass;
             float m_rr_threshold;
             float m_alpha;
+            float m_memory_budget;
 
         private:
-            void findHitPoints(const core::Scene& scene, int x, int y, int id);
-            void tracePhoton(const core::Scene& scene, int id, float one_over_width);
-            float update(const core::Scene& scene, int x, int y);
-            void estimateDirect(const core::Scene& scene, geometry::Ray& ray, int x, int y, int id);
+            void integrateTiles(const core::Scene& scene, core::Image& output, double time_limit);
+            void writeTiles(const core::Scene& scene, core::Image& output) const;
+            //Writes the tiles of the current group to m_progress. It must be called between passes, while no worker updates the hitpoints.
+            void publishProgress(const core::Scene& scene);
+            void findHitPoints(const core::Scene& scene, int x, int y, int offset, int pass, int id);
+            void tracePhoton(const core::Scene& scene, std::uint64_t photon_index, int id);
+            float update(const core::Scene& scene, int x, int y, int offset);
+            void estimateDirect(const core::Scene& scene, geometry::Ray& ray, geometry::Intersection& intersection, int index, int id);
+            geometry::Intersection getHitPointIntersection(int index) const;
+            void compactPhotonDeposits(std::vector<PhotonDeposit>& deposits) const;
+            void mergePhotonDeposits(int start, int end);
+            void getGridBuckets(int index, std::vector<int>& buckets) const;
+            int hashGridCell(const glm::ivec3& cell, int level) const;
         };
     }
 }
@@ -29,7 +29,7 @@ namespace glue
 			, m_pdf(1.0f / m_object->getSurfaceArea())
 		{}
 
-		Photon DiffuseArealight::castPhoton(core::UniformSampler& sampler) const
+		Photon DiffuseArealight::castPhoton(const core::Scene& scene, core::RealSampler& sampler) const
 		{
 			//We sample hemisphere with cosine-weighted sampling.
 			//Initial throughput is glm::dot(ray.dir, plane.normal) * Le / (glm::dot(ray.dir, plane.normal) * one_over_pi * m_pdf)
@@ -37,11 +37,17 @@ namespace glue
 			auto plane = m_object->samplePlane(sampler);
 			core::CoordinateSpace tangent_space(plane.point, plane.normal);
 
-			auto dir = core::math::sampleHemisphereCosine(sampler.sample(), sampler.sample()).toCartesianCoordinate();
+			auto u = sampler.get2D();
+			auto dir = core::math::sampleHemisphereCosine(u.x, u.y).toCartesianCoordinate();
 			return Photon(geometry::Ray(plane.point, tangent_space.vectorToWorldSpace(dir)), m_flux);
 		}
 
-		LightSample DiffuseArealight::sample(core::UniformSampler& sampler, const geometry::Intersection& intersection) const
+		glm::vec3 DiffuseArealight::getFlux(const core::Scene& scene) const
+		{
+			return m_flux;
+		}
+
+		LightSample DiffuseArealight::sample(core::RealSampler& sampler, const geometry::Intersection& intersection) const
 		{
 			LightSample light_sample;
 
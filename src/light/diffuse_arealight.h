@@ -26,8 +26,9 @@ namespace glue
 		public:
 			explicit DiffuseArealight(const DiffuseArealight::Xml& xml);
 
-			Photon castPhoton(core::UniformSampler& sampler) const override;
-			LightSample sample(core::UniformSampler& sampler, const geometry::Intersection& intersection) const override;
+			Photon castPhoton(const core::Scene& scene, core::RealSampler& sampler) const override;
+			glm::vec3 getFlux(const core::Scene& scene) const override;
+			LightSample sample(core::RealSampler& sampler, const geometry::Intersection& intersection) const override;
 			LightSample getVisibleSample(const core::Scene& scene, const geometry::Ray& ray) const override;
 			glm::vec3 getLe(const glm::vec3& wi_world, const glm::vec3& light_plane_normal, float distance) const override;
 			float getPdf(const glm::vec3& wi_world, const glm::vec3& light_plane_normal, float distance) const override;
@@ -2,6 +2,8 @@
 #include "../geometry/spherical_coordinate.h"
 #include "../xml/node.h"
 #include "../core/math.h"
+#include "../core/coordinate_space.h"
+#include "../core/memory.h"
 #include "../core/scene.h"
 #include "../geometry/mapper.h"
 
@@ -27,25 +29,63 @@ namespace glue
 		EnvironmentLight::EnvironmentLight(const EnvironmentLight::Xml& xml)
 			: m_hdri(xml.hdri)
 			, m_transformation(xml.transformation)
+			, m_radiance_integral(0.0f)
 		{
 			int width = m_hdri.getWidth();
 			int height = m_hdri.getHeight();
 
 			std::vector<std::vector<float>> pdfs(width, std::vector<float>(height));
+			auto texel_solid_angle = glm::two_pi<float>() * glm::pi<float>() / (width * height);
 
 			for (int i = 0; i < width; ++i)
 			{
 				for (int j = 0; j < height; ++j)
 				{
 					glm::vec2 uv((i + 0.5f) / width, (j + 0.5f) / height);
-					pdfs[i][j] = core::math::rgbToLuminance(m_hdri.fetchTexelNearest(uv, 0)) * glm::sin(uv.y * glm::pi<float>());
+					auto le = m_hdri.fetchTexelNearest(uv, 0);
+					auto sin_theta = glm::sin(uv.y * glm::pi<float>());
+					pdfs[i][j] = core::math::rgbToLuminance(le) * sin_theta;
+					m_radiance_integral += le * sin_theta * texel_solid_angle;
 				}
 			}
 
 			m_sampler = core::Discrete2DSampler(pdfs);
+			core::memory::set("Light samplers", "EnvironmentLight", m_sampler.getMemoryUsage());
 		}
 
-		LightSample EnvironmentLight::sample(core::UniformSampler& sampler, const geometry::Intersection& intersection) const
+		Photon EnvironmentLight::castPhoton(const core::Scene& scene, core::RealSampler& sampler) const
+		{
+			//Photons are emitted from a disk that is perpendicular to the sampled direction and covers the bounding sphere of the scene.
+			//Initial throughput is Le / (pdf_w * (1 / (pi * radius^2))).
+			auto ij = m_sampler.sample(sampler);
+			glm::vec2 uv((ij.first + 0.5f) / m_hdri.getWidth(), (ij.second + 0.5f) / m_hdri.getHeight());
+			auto wi_object = geometry::SphericalCoordinate(1.0f, uv.y * glm::pi<float>(), uv.x * glm::two_pi<float>()).toCartesianCoordinate();
+			auto le = getLeObjectSpace(wi_object, glm::vec3(0.0f), 0.0f);
+			auto pdf_w = getPdfObjectSpace(wi_object, glm::vec3(0.0f), 0.0f);
+			auto wi_world = glm::normalize(m_transformation.vectorToWorldSpace(wi_object));
+
+			auto bbox = scene.getBBox();
+			auto center = (bbox.get_min() + bbox.get_max()) * 0.5f;
+			auto radius = glm::length(bbox.get_max() - bbox.get_min()) * 0.5f;
+
+			core::CoordinateSpace disk_space(center + wi_world * radius, wi_world);
+			auto u = sampler.get2D();
+			auto disk_point = core::math::sampleDiskUniform(u.x, u.y) * radius;
+			auto origin = disk_space.pointToWorldSpace(glm::vec3(disk_point.x, disk_point.y, 0.0f));
+
+			return Photon(geometry::Ray(origin, -wi_world), le * glm::pi<float>() * radius * radius / pdf_w);
+		}
+
+		glm::vec3 EnvironmentLight::getFlux(const core::Scene& scene) const
+		{
+			//Radiance arriving to the scene passes through the disk that covers the bounding sphere of the scene.
+			auto bbox = scene.getBBox();
+			auto radius = glm::length(bbox.get_max() - bbox.get_min()) * 0.5f;
+
+			return m_radiance_integral * glm::pi<float>() * radius * radius;
+		}
+
+		LightSample EnvironmentLight::sample(core::RealSampler& sampler, const geometry::Intersection& intersection) const
 		{
 			LightSample light_sample;
 
@@ -81,6 +121,15 @@ namespace glue
 			return m_hdri.fetchTexelNearest(uv, 0);
 		}
 
+		glm::vec3 EnvironmentLight::getFilteredLe(const glm::vec3& wi_world, float spread_angle) const
+		{
+			auto uv = geometry::SphericalMapper().mapOnlyUV(m_transformation.vectorToObjectSpace(wi_world), glm::vec3(0.0f)).uv;
+			//u spans 2pi and v spans pi radians of the sphere.
+			auto level = m_hdri.getLevel(spread_angle * glm::one_over_two_pi<float>(), spread_angle * glm::one_over_pi<float>());
+
+			return m_hdri.fetchTrilinear(uv, level);
+		}
+
 		float EnvironmentLight::getPdf(const glm::vec3& wi_world, const glm::vec3& light_plane_normal, float distance) const
 		{
 			auto uv = geometry::SphericalMapper().mapOnlyUV(m_transformation.vectorToObjectSpace(wi_world), glm::vec3(0.0f)).uv;
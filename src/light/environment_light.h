@@ -27,18 +27,23 @@ namespace glue
 		public:
 			explicit EnvironmentLight(const EnvironmentLight::Xml& xml);
 
-			Photon castPhoton(core::UniformSampler& sampler) const override { return Photon(); }
-			LightSample sample(core::UniformSampler& sampler, const geometry::Intersection& intersection) const override;
+			Photon castPhoton(const core::Scene& scene, core::RealSampler& sampler) const override;
+			glm::vec3 getFlux(const core::Scene& scene) const override;
+			LightSample sample(core::RealSampler& sampler, const geometry::Intersection& intersection) const override;
 			LightSample getVisibleSample(const core::Scene& scene, const geometry::Ray& ray) const override;
 			glm::vec3 getLe(const glm::vec3& wi_world, const glm::vec3& light_plane_normal, float distance) const override;
 			float getPdf(const glm::vec3& wi_world, const glm::vec3& light_plane_normal, float distance) const override;
 			bool hasDeltaDistribution() const override;
 			std::shared_ptr<geometry::Object> getObject() const override;
+			//Le averaged over a cone of directions, for rays that escape the scene. Light sampling keeps using the unfiltered Le,
+			//since its distribution is built from the full resolution.
+			glm::vec3 getFilteredLe(const glm::vec3& wi_world, float spread_angle) const;
 
 		private:
 			texture::ImageTexture m_hdri;
 			core::Discrete2DSampler m_sampler;
 			geometry::Transformation m_transformation;
+			glm::vec3 m_radiance_integral; //Integral of Le over the whole sphere of directions.
 
 		private:
 			glm::vec3 getLeObjectSpace(const glm::vec3& wi_object, const glm::vec3& light_plane_normal, float distance) const;
@@ -50,8 +50,10 @@ namespace glue
 		public:
 			virtual ~Light() = default;
 
-			virtual Photon castPhoton(core::UniformSampler& sampler) const = 0;
-			virtual LightSample sample(core::UniformSampler& sampler, const geometry::Intersection& intersection) const = 0;
+			virtual Photon castPhoton(const core::Scene& scene, core::RealSampler& sampler) const = 0;
+			//Total power emitted into the scene. Used to distribute photons among the lights.
+			virtual glm::vec3 getFlux(const core::Scene& scene) const = 0;
+			virtual LightSample sample(core::RealSampler& sampler, const geometry::Intersection& intersection) const = 0;
 			virtual LightSample getVisibleSample(const core::Scene& scene, const geometry::Ray& ray) const = 0;
 			virtual glm::vec3 getLe(const glm::vec3& wi_world, const glm::vec3& light_plane_normal, float distance) const = 0;
 			virtual float getPdf(const glm::vec3& wi_world, const glm::vec3& light_plane_normal, float distance) const = 0;
@@ -1,5 +1,7 @@
 #include "pointlight.h"
 #include "../geometry/intersection.h"
+#include "../core/real_sampler.h"
+#include "../core/math.h"
 #include "../xml/node.h"
 
 #include <glm/gtc/constants.hpp>
@@ -26,7 +28,20 @@ namespace glue
 			, m_intensity(xml.flux / (4.0f * glm::pi<float>()))
 		{}
 
-		LightSample Pointlight::sample(core::UniformSampler& sampler, const geometry::Intersection& intersection) const
+		Photon Pointlight::castPhoton(const core::Scene& scene, core::RealSampler& sampler) const
+		{
+			//Directions are sampled uniformly over the sphere, so the initial throughput is intensity / (1 / 4pi) which is the flux.
+			auto u = sampler.get2D();
+			auto dir = core::math::sampleSphereUniform(u.x, u.y).toCartesianCoordinate();
+			return Photon(geometry::Ray(m_position, dir), getFlux(scene));
+		}
+
+		glm::vec3 Pointlight::getFlux(const core::Scene& scene) const
+		{
+			return m_intensity * (4.0f * glm::pi<float>());
+		}
+
+		LightSample Pointlight::sample(core::RealSampler& sampler, const geometry::Intersection& intersection) const
 		{
 			LightSample light_sample;
 
@@ -1,17 +1,46 @@
 #include "core/scene.h"
+#include "core/memory.h"
+#include "core/stats.h"
 #include "core/timer.h"
+#include "core/trace.h"
 #include "integrator/pathtracer.h"
 #include "xml/node.h"
 
+#include <csignal>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: glue <scene> [--resume <checkpoint>] [--tiles <part> <part count>]" << std::endl;
+        std::cout << "                    [--samples <begin> <end>] [--partial <path>] [--stats <path>]" << std::endl;
+        std::cout << "                    [--trace <path>]" << std::endl;
+        std::cout << "       glue <scene> --merge <partial>..." << std::endl;
+    }
+
+    int parseInt(const char* argument)
+    {
+        try
+        {
+            return std::stoi(argument);
+        }
+        catch (const std::exception&)
+        {
+            throw std::runtime_error(std::string("Error: ") + argument + " is not an integer");
+        }
+    }
+}
 
 int main(int argc, char* argv[])
 {
-    if (argc != 2)
+    if (argc < 2)
     {
-        std::cout << "Please indicate input location as the first argument of the program." << std::endl;
-        std::cout << "Do not add any other program arguments." << std::endl;
-        return 0;
+        printUsage();
+        return 1;
     }
 
 	try
@@ -19,15 +48,111 @@ int main(int argc, char* argv[])
         using namespace glue;
         core::Timer timer;
 
+        std::string resume_path;
+        std::string stats_path;
+        std::string trace_path;
+        std::vector<std::string> merge_paths;
+        core::RenderJob job;
+        for (int i = 2; i < argc; ++i)
+        {
+            std::string argument(argv[i]);
+            if (argument == "--resume" && i + 1 < argc)
+            {
+                resume_path = argv[++i];
+            }
+            else if (argument == "--tiles" && i + 2 < argc)
+            {
+                job.tile_part = parseInt(argv[++i]);
+                job.tile_part_count = parseInt(argv[++i]);
+            }
+            else if (argument == "--samples" && i + 2 < argc)
+            {
+                job.sample_begin = parseInt(argv[++i]);
+                job.sample_end = parseInt(argv[++i]);
+            }
+            else if (argument == "--partial" && i + 1 < argc)
+            {
+                job.partial_path = argv[++i];
+            }
+            else if (argument == "--stats" && i + 1 < argc)
+            {
+                stats_path = argv[++i];
+            }
+            else if (argument == "--trace" && i + 1 < argc)
+            {
+                trace_path = argv[++i];
+                core::trace::enable();
+            }
+            else if (argument == "--merge" && i + 1 < argc)
+            {
+                merge_paths.assign(argv + i + 1, argv + argc);
+                break;
+            }
+            else
+            {
+                printUsage();
+                return 1;
+            }
+        }
+        if (job.tile_part_count < 1 || job.tile_part < 0 || job.tile_part >= job.tile_part_count ||
+            job.sample_begin < 0 || (job.sample_end > 0 && job.sample_end <= job.sample_begin))
+        {
+            printUsage();
+            return 1;
+        }
+
 		timer.start();
-        core::Scene scene(core::Scene::Xml(xml::Node::getRoot(argv[1])));
+        auto scene_xml = [&argv]()
+        {
+            core::trace::Scope scope("Parse XML", argv[1]);
+            return core::Scene::Xml(xml::Node::getRoot(argv[1]));
+        }();
+        //Merging only needs the outputs of the scene.
+        if (!merge_paths.empty())
+        {
+            core::Scene::mergePartials(scene_xml, merge_paths);
+            std::cout << "Merge time: " << timer.getTime() << std::endl;
+            return 0;
+        }
+
+        core::Scene scene(scene_xml);
+        scene.job = job;
 		std::cout << "BVH build and input read time: " << timer.getTime() << std::endl;
+        core::stats::addPhaseTime("Load", timer.getTime());
+        core::memory::printReport(std::cout, false);
+
+        //Interrupted renders stop at the end of the current sample and still save their outputs.
+        auto stop_handler = [](int) { core::Scene::requestStop(); };
+        std::signal(SIGINT, stop_handler);
+        std::signal(SIGTERM, stop_handler);
+
+        if (!resume_path.empty())
+        {
+            scene.loadCheckpoint(resume_path);
+        }
 
 		scene.render();
+        core::memory::printReport(std::cout, true);
+
+        //Counters are only collected if the renderer is built with GLUE_STATS, but the phase times are written either way.
+        if (!stats_path.empty())
+        {
+            if (!core::stats::cEnabled)
+            {
+                std::cout << "Warning: glue is built without GLUE_STATS, so " << stats_path << " only has phase times and memory usage" << std::endl;
+            }
+            core::stats::writeReport(stats_path);
+        }
+        if (!trace_path.empty())
+        {
+            core::trace::write(trace_path);
+        }
 	}
 	catch (const std::runtime_error& e)
 	{
+		//Failed renders, resumes and merges return an error code so that scripts can detect them.
 		std::cout << e.what() << std::endl;
+		return 1;
 	}
 
 	return 0;
@@ -27,12 +27,12 @@ namespace glue
 			, m_roughness(xml.roughness->create())
 		{}
 
-        std::pair<int, float> Dielectric::chooseBsdf(const glm::vec3& wo_tangent, core::UniformSampler& sampler, const geometry::Intersection& intersection) const
+        std::pair<int, float> Dielectric::chooseBsdf(const glm::vec3& wo_tangent, core::RealSampler& sampler, const geometry::Intersection& intersection) const
 		{
             return sampler.sample() < 0.5f ? std::make_pair(0, 0.5f) : std::make_pair(1, 0.5f);
 		}
 
-		std::pair<glm::vec3, glm::vec3> Dielectric::sampleWi(const glm::vec3& wo_tangent, core::UniformSampler& sampler, const geometry::Intersection& intersection) const
+		std::pair<glm::vec3, glm::vec3> Dielectric::sampleWi(const glm::vec3& wo_tangent, core::RealSampler& sampler, const geometry::Intersection& intersection) const
 		{
 			auto no_over_ni = core::math::cosTheta(wo_tangent) > 0.0f ? 1.0f / m_ior_n : m_ior_n;
 
@@ -32,8 +32,8 @@ namespace glue
 		public:
 			explicit Dielectric(const Dielectric::Xml& xml);
 
-            std::pair<int, float> chooseBsdf(const glm::vec3& wo_tangent, core::UniformSampler& sampler, const geometry::Intersection& intersection) const override;
-			std::pair<glm::vec3, glm::vec3> sampleWi(const glm::vec3& wo_tangent, core::UniformSampler& sampler, const geometry::Intersection& intersection) const override;
+            std::pair<int, float> chooseBsdf(const glm::vec3& wo_tangent, core::RealSampler& sampler, const geometry::Intersection& intersection) const override;
+			std::pair<glm::vec3, glm::vec3> sampleWi(const glm::vec3& wo_tangent, core::RealSampler& sampler, const geometry::Intersection& intersection) const override;
 			glm::vec3 getBsdf(const glm::vec3& wi_tangent, const glm::vec3& wo_tangent, const geometry::Intersection& intersection) const override;
 			float getPdf(const glm::vec3& wi_tangent, const glm::vec3& wo_tangent, const geometry::Intersection& intersection) const override;
 			bool hasDeltaDistribution(const geometry::Intersection& intersection) const override;
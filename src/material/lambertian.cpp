@@ -29,14 +29,15 @@ namespace glue
 			: m_kd(xml.kd->create())
 		{}
 
-		std::pair<glm::vec3, glm::vec3> Lambertian::sampleWi(const glm::vec3& wo_tangent, core::UniformSampler& sampler, const geometry::Intersection& intersection) const
+		std::pair<glm::vec3, glm::vec3> Lambertian::sampleWi(const glm::vec3& wo_tangent, core::RealSampler& sampler, const geometry::Intersection& intersection) const
 		{
 			glm::vec3 wi(0.0f);
 			glm::vec3 f(0.0f);
 
 			if (core::math::cosTheta(wo_tangent) > 0.0f)
 			{
-				wi = core::math::sampleHemisphereCosine(sampler.sample(), sampler.sample()).toCartesianCoordinate();
+				auto u = sampler.get2D();
+				wi = core::math::sampleHemisphereCosine(u.x, u.y).toCartesianCoordinate();
 				f = m_kd->fetch(intersection);
 			}
 
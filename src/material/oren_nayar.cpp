@@ -35,14 +35,15 @@ namespace glue
 			m_B = 0.45f * r2 / (r2 + 0.09f);
 		}
 
-		std::pair<glm::vec3, glm::vec3> OrenNayar::sampleWi(const glm::vec3& wo_tangent, core::UniformSampler& sampler, const geometry::Intersection& intersection) const
+		std::pair<glm::vec3, glm::vec3> OrenNayar::sampleWi(const glm::vec3& wo_tangent, core::RealSampler& sampler, const geometry::Intersection& intersection) const
 		{
 			glm::vec3 wi(0.0f);
 			glm::vec3 f(0.0f);
 
 			if (core::math::cosTheta(wo_tangent) > 0.0f)
 			{
-				wi = core::math::sampleHemisphereCosine(sampler.sample(), sampler.sample()).toCartesianCoordinate();
+				auto u = sampler.get2D();
+				wi = core::math::sampleHemisphereCosine(u.x, u.y).toCartesianCoordinate();
 				f = getBsdf(wi, wo_tangent, intersection) * glm::pi<float>();
 			}
 
@@ -38,7 +38,8 @@ namespace glue
 			auto one_over_ior = 1.0f / m_ior_n;
 			for (int i = 0; i < n; ++i)
 			{
-				auto dir = core::math::sampleHemisphereCosine(sampler.sample(), sampler.sample()).toCartesianCoordinate();
+				auto u = sampler.get2D();
+				auto dir = core::math::sampleHemisphereCosine(u.x, u.y).toCartesianCoordinate();
 
 				m_fsum += microfacet::fresnel::Dielectric()(one_over_ior, core::math::cosTheta(dir));
 			}
@@ -46,14 +47,14 @@ namespace glue
 			m_fsum /= n;
 		}
 
-		std::pair<int, float> SmoothLayered::chooseBsdf(const glm::vec3& wo_tangent, core::UniformSampler& sampler, const geometry::Intersection& intersection) const
+		std::pair<int, float> SmoothLayered::chooseBsdf(const glm::vec3& wo_tangent, core::RealSampler& sampler, const geometry::Intersection& intersection) const
 		{
 			auto fresnel = microfacet::fresnel::Dielectric()(m_ior_n, core::math::cosTheta(wo_tangent));
 
 			return sampler.sample() < fresnel ? std::make_pair(0, fresnel) : std::make_pair(1, 1.0f - fresnel);
 		}
 
-		std::pair<glm::vec3, glm::vec3> SmoothLayered::sampleWi(const glm::vec3& wo_tangent, core::UniformSampler& sampler, const geometry::Intersection& intersection) const
+		std::pair<glm::vec3, glm::vec3> SmoothLayered::sampleWi(const glm::vec3& wo_tangent, core::RealSampler& sampler, const geometry::Intersection& intersection) const
 		{
 			glm::vec3 wi(0.0f);
 			glm::vec3 f(0.0f);
@@ -70,7 +71,8 @@ namespace glue
 					break;
 
 				case 1:
-                    wi = core::math::sampleHemisphereCosine(sampler.sample(), sampler.sample()).toCartesianCoordinate();
+                    auto u = sampler.get2D();
+                    wi = core::math::sampleHemisphereCosine(u.x, u.y).toCartesianCoordinate();
 					auto f_in = microfacet::fresnel::Dielectric()(m_ior_n, core::math::cosTheta(wi));
 					auto kd = m_kd->fetch(intersection);
 					f = 1.0f / (m_ior_n * m_ior_n) * (1.0f - f_in) * (1.0f - f_out) * kd / (1.0f - m_fsum * kd);
@@ -15,11 +15,12 @@ namespace glue
 			: m_ab(roughness)
 		{}
 
-		glm::vec3 BeckmannDistribution::sampleWhWmlt07(core::UniformSampler& sampler) const
+		glm::vec3 BeckmannDistribution::sampleWhWmlt07(core::RealSampler& sampler) const
 		{
+			auto u = sampler.get2D();
 			return geometry::SphericalCoordinate(1.0f,
-				glm::atan(glm::sqrt(-m_ab * m_ab * glm::log(1.0f - sampler.sample()))),
-				glm::two_pi<float>() * sampler.sample()).toCartesianCoordinate();
+				glm::atan(glm::sqrt(-m_ab * m_ab * glm::log(1.0f - u.x))),
+				glm::two_pi<float>() * u.y).toCartesianCoordinate();
 		}
 
 		float BeckmannDistribution::pdfWmlt07(const glm::vec3& wh_tangent) const
@@ -27,7 +28,7 @@ namespace glue
 			return glm::abs(d(wh_tangent) * core::math::cosTheta(wh_tangent));
 		}
 
-		glm::vec3 BeckmannDistribution::sampleWhHd14(const glm::vec3& wv_tangent, core::UniformSampler& sampler) const
+		glm::vec3 BeckmannDistribution::sampleWhHd14(const glm::vec3& wv_tangent, core::RealSampler& sampler) const
 		{
 			auto wi = core::math::cosTheta(wv_tangent) < 0.0f ? -wv_tangent : wv_tangent;
 
@@ -42,8 +43,9 @@ namespace glue
 
 			//2-Sample P22
 			glm::vec2 slope;
-			auto u1 = sampler.sample();
-			auto u2 = sampler.sample();
+			auto u = sampler.get2D();
+			auto u1 = u.x;
+			auto u2 = u.y;
 			if (spherical_stretched_wi.theta > 0.0001f)
 			{
 				auto sintheta_wi = glm::sin(spherical_stretched_wi.theta);
@@ -14,12 +14,12 @@ namespace glue
 			: m_ag(roughness)
 		{}
 
-		glm::vec3 GGXDistribution::sampleWhWmlt07(core::UniformSampler& sampler) const
+		glm::vec3 GGXDistribution::sampleWhWmlt07(core::RealSampler& sampler) const
 		{
-			auto u = sampler.sample();
+			auto u = sampler.get2D();
 			return geometry::SphericalCoordinate(1.0f,
-				glm::atan(m_ag * glm::sqrt(u) / glm::sqrt(1.0f - u)),
-				glm::two_pi<float>() * sampler.sample()).toCartesianCoordinate();
+				glm::atan(m_ag * glm::sqrt(u.x) / glm::sqrt(1.0f - u.x)),
+				glm::two_pi<float>() * u.y).toCartesianCoordinate();
 		}
 
 		float GGXDistribution::pdfWmlt07(const glm::vec3& wh_tangent) const
@@ -27,7 +27,7 @@ namespace glue
 			return glm::abs(d(wh_tangent) * core::math::cosTheta(wh_tangent));
 		}
 
-		glm::vec3 GGXDistribution::sampleWhHd14(const glm::vec3& wv_tangent, core::UniformSampler& sampler) const
+		glm::vec3 GGXDistribution::sampleWhHd14(const glm::vec3& wv_tangent, core::RealSampler& sampler) const
 		{
 			auto wi = core::math::cosTheta(wv_tangent) < 0.0f ? -wv_tangent : wv_tangent;
 
@@ -41,8 +41,9 @@ namespace glue
 			auto t1 = core::math::cosTheta(stretched_wi) < 0.9999f ? glm::normalize(glm::cross(stretched_wi, glm::vec3(0.0f, 0.0f, 1.0f))) : glm::vec3(1.0f, 0.0f, 0.0f);
 			auto t2 = glm::cross(t1, stretched_wi);
 			//Sample a point from one of the half disks.
-			auto u1 = sampler.sample();
-			auto u2 = sampler.sample();
+			auto u = sampler.get2D();
+			auto u1 = u.x;
+			auto u2 = u.y;
 			auto a = 1.0f / (1.0f + core::math::cosTheta(stretched_wi));
 			auto r = glm::sqrt(u1);
 			auto phi = u2 < a ? u2 / a * glm::pi<float>() : glm::pi<float>() + (u2 - a) / (1.0f - a) * glm::pi<float>();
@@ -14,7 +14,7 @@ namespace glue
 		{}
 
 		template<typename MicrofacetDistribution, bool tSampleVisibleNormals>
-		std::pair<glm::vec3, glm::vec3> MicrofacetReflection<MicrofacetDistribution, tSampleVisibleNormals>::sampleWi(const glm::vec3& wo_tangent, core::UniformSampler& sampler,
+		std::pair<glm::vec3, glm::vec3> MicrofacetReflection<MicrofacetDistribution, tSampleVisibleNormals>::sampleWi(const glm::vec3& wo_tangent, core::RealSampler& sampler,
 				float nt_over_ni) const
 		{
 			glm::vec3 wh;
@@ -45,7 +45,7 @@ namespace glue
 		}
 
 		template<typename MicrofacetDistribution, bool tSampleVisibleNormals>
-		std::pair<glm::vec3, glm::vec3> MicrofacetReflection<MicrofacetDistribution, tSampleVisibleNormals>::sampleWi(const glm::vec3& wo_tangent, core::UniformSampler& sampler,
+		std::pair<glm::vec3, glm::vec3> MicrofacetReflection<MicrofacetDistribution, tSampleVisibleNormals>::sampleWi(const glm::vec3& wo_tangent, core::RealSampler& sampler,
 			const glm::vec3& nt_over_ni, const glm::vec3& kt_over_ki) const
 		{
 			glm::vec3 wh;
@@ -11,7 +11,7 @@ namespace glue
 		public:
 			explicit MicrofacetRefraction(float roughness);
 
-			std::pair<glm::vec3, glm::vec3> sampleWi(const glm::vec3& wo_tangent, core::UniformSampler& sampler, float nt_over_ni) const;
+			std::pair<glm::vec3, glm::vec3> sampleWi(const glm::vec3& wo_tangent, core::RealSampler& sampler, float nt_over_ni) const;
 			glm::vec3 getBsdf(const glm::vec3& wi_tangent, const glm::vec3& wo_tangent, float nt_over_ni) const;
 			float getPdf(const glm::vec3& wi_tangent, const glm::vec3& wo_tangent, float nt_over_ni) const;
 
@@ -15,7 +15,7 @@ namespace glue
 		{}
 
 		template<typename MicrofacetDistribution, bool tSampleVisibleNormals>
-		std::pair<glm::vec3, glm::vec3> MicrofacetRefraction<MicrofacetDistribution, tSampleVisibleNormals>::sampleWi(const glm::vec3& wo_tangent, core::UniformSampler& sampler,
+		std::pair<glm::vec3, glm::vec3> MicrofacetRefraction<MicrofacetDistribution, tSampleVisibleNormals>::sampleWi(const glm::vec3& wo_tangent, core::RealSampler& sampler,
 		        float nt_over_ni) const
 		{
 			MicrofacetDistribution microfacet(m_a);
@@ -2,6 +2,8 @@
 #include "../xml/node.h"
 #include "../xml/parser.h"
 
+#include <glm/glm.hpp>
+
 namespace glue
 {
 	namespace texture
@@ -17,18 +19,35 @@ namespace glue
 			}
 		}
 
+		ImageTexture::Xml::Xml(const std::string& p_datapath)
+			: datapath(p_datapath)
+		{}
+
 		std::unique_ptr<Texture> ImageTexture::Xml::create() const
 		{
 			return std::make_unique<ImageTexture>(*this);
 		}
 
 		ImageTexture::ImageTexture(const ImageTexture::Xml& xml)
-			: m_images(xml::Parser::loadImage(xml.datapath))
+			: m_images(xml::Parser::loadImage(xml.datapath, true))
 		{}
 
 		glm::vec3 ImageTexture::fetch(const geometry::Intersection& intersection) const
 		{
-			return fetchTexelNearest(intersection.uv, 0);
+			//dpdu and dpdv are the world space lengths of the unit texture coordinates, so the footprint is scaled by their inverses.
+			//Surfaces without texture coordinates have zero derivatives and use the finest level.
+			if (intersection.footprint <= 0.0f)
+			{
+				return fetchBilinear(intersection.uv, 0);
+			}
+			auto length_u = glm::length(intersection.dpdu);
+			auto length_v = glm::length(intersection.dpdv);
+			if (length_u <= 0.0f || length_v <= 0.0f)
+			{
+				return fetchBilinear(intersection.uv, 0);
+			}
+
+			return fetchTrilinear(intersection.uv, getLevel(intersection.footprint / length_u, intersection.footprint / length_v));
 		}
 
 		glm::vec3 ImageTexture::fetchTexelNearest(const glm::vec2& uv, int mipmap_level) const
@@ -39,7 +58,57 @@ namespace glue
 			auto u = glm::fract(uv.x);
 			auto v = 1.0f - glm::fract(uv.y);
 
-			return mipmap.get(static_cast<int>(mipmap.get_width() * u), static_cast<int>(mipmap.get_height() * v));
+			return mipmap.get(glm::min(static_cast<int>(mipmap.get_width() * u), mipmap.get_width() - 1),
+				glm::min(static_cast<int>(mipmap.get_height() * v), mipmap.get_height() - 1));
+		}
+
+		glm::vec3 ImageTexture::fetchBilinear(const glm::vec2& uv, int mipmap_level) const
+		{
+			auto& mipmap = (*m_images)[mipmap_level];
+			auto width = mipmap.get_width();
+			auto height = mipmap.get_height();
+
+			//Always in REPEAT mode. Texel centers are at half integers.
+			auto x = glm::fract(uv.x) * width - 0.5f;
+			auto y = (1.0f - glm::fract(uv.y)) * height - 0.5f;
+			auto x0 = static_cast<int>(glm::floor(x));
+			auto y0 = static_cast<int>(glm::floor(y));
+			auto tx = x - x0;
+			auto ty = y - y0;
+
+			auto wrap = [](int i, int size) { return i < 0 ? i + size : (i >= size ? i - size : i); };
+			auto x1 = wrap(x0 + 1, width);
+			auto y1 = wrap(y0 + 1, height);
+			x0 = wrap(x0, width);
+			y0 = wrap(y0, height);
+
+			return glm::mix(glm::mix(mipmap.get(x0, y0), mipmap.get(x1, y0), tx), glm::mix(mipmap.get(x0, y1), mipmap.get(x1, y1), tx), ty);
+		}
+
+		glm::vec3 ImageTexture::fetchTrilinear(const glm::vec2& uv, float level) const
+		{
+			auto max_level = getLevelCount() - 1;
+			level = glm::clamp(level, 0.0f, static_cast<float>(max_level));
+			auto level0 = static_cast<int>(level);
+			auto t = level - level0;
+			if (t <= 0.0f || level0 == max_level)
+			{
+				return fetchBilinear(uv, level0);
+			}
+
+			return glm::mix(fetchBilinear(uv, level0), fetchBilinear(uv, level0 + 1), t);
+		}
+
+		float ImageTexture::getLevel(float footprint_u, float footprint_v) const
+		{
+			auto texels = glm::max(footprint_u * getWidth(), footprint_v * getHeight());
+
+			return texels > 1.0f ? glm::log2(texels) : 0.0f;
+		}
+
+		int ImageTexture::getLevelCount() const
+		{
+			return m_images->size();
 		}
 
 		int ImageTexture::getWidth() const
@@ -19,14 +19,22 @@ namespace glue
 				std::string datapath;
 
 				explicit Xml(const xml::Node& node);
+				explicit Xml(const std::string& p_datapath);
 				std::unique_ptr<Texture> create() const override;
 			};
 
 		public:
 			explicit ImageTexture(const ImageTexture::Xml& xml);
 
+			//Filters over the footprint of the intersection with trilinear interpolation of the mip levels.
 			glm::vec3 fetch(const geometry::Intersection& intersection) const override;
 			glm::vec3 fetchTexelNearest(const glm::vec2& uv, int mipmap_level) const;
+			glm::vec3 fetchBilinear(const glm::vec2& uv, int mipmap_level) const;
+			//Level 0 is the full resolution. Fractional levels blend the two levels around them.
+			glm::vec3 fetchTrilinear(const glm::vec2& uv, float level) const;
+			//Level at which a texel is as large as the footprint, whose extents are given in texture coordinates.
+			float getLevel(float footprint_u, float footprint_v) const;
+			int getLevelCount() const;
 			int getWidth() const;
 			int getHeight() const;
 
@@ -1,6 +1,10 @@
 #include "parser.h"
 #include "../geometry/triangle.h"
+#include "../core/memory.h"
+#include "../core/trace.h"
+#include <future>
 #include <iostream>
+#include <mutex>
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
@@ -8,15 +12,72 @@ namespace glue
 {
 	namespace xml
 	{
+		namespace
+		{
+			thread_local int tReplica = 0;
+
+			std::unordered_map<std::string, std::shared_future<std::shared_ptr<geometry::BVH<geometry::Triangle>>>> gPathToBVH;
+			std::mutex gPathToBVHMutex;
+			std::unordered_map<std::string, std::shared_future<std::shared_ptr<std::vector<core::Image>>>> gPathToImage;
+			std::mutex gPathToImageMutex;
+
+			inline std::string getCacheKey(const std::string& path)
+			{
+				return std::to_string(tReplica) + ':' + path;
+			}
+
+			inline std::string getMemoryEntryName(const std::string& path)
+			{
+				return tReplica > 0 ? path + " (replica " + std::to_string(tReplica) + ")" : path;
+			}
+
+			//Objects are created in parallel, so the caches are shared between threads.
+			//A file is loaded only once while the other threads that need it wait for the result.
+			template<typename T, typename Load>
+			std::shared_ptr<T> loadCached(std::unordered_map<std::string, std::shared_future<std::shared_ptr<T>>>& cache, std::mutex& mutex,
+				const std::string& key, const Load& load)
+			{
+				std::promise<std::shared_ptr<T>> promise;
+				std::shared_future<std::shared_ptr<T>> future;
+				bool owner = false;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					auto iter = cache.find(key);
+					if (iter == cache.end())
+					{
+						future = cache[key] = promise.get_future().share();
+						owner = true;
+					}
+					else
+					{
+						future = iter->second;
+					}
+				}
+
+				if (owner)
+				{
+					try
+					{
+						promise.set_value(load());
+					}
+					catch (...)
+					{
+						promise.set_exception(std::current_exception());
+					}
+				}
+
+				return future.get();
+			}
+		}
+
 		const std::unordered_set<std::string> Parser::gSupportedFormatsLoad{ "jpg", "png", "tga", "bmp", "psd", "gif", "hdr", "pic" };
 		const std::unordered_set<std::string> Parser::gSupportedFormatsSave{ "png", "bmp", "tga" };
 
 		std::shared_ptr<geometry::BVH<geometry::Triangle>> Parser::loadModel(const std::string& path)
 		{
-			static std::unordered_map<std::string, std::shared_ptr<geometry::BVH<geometry::Triangle>>> path_to_bvh;
-
-			if (path_to_bvh.find(path) == path_to_bvh.end())
+			return loadCached(gPathToBVH, gPathToBVHMutex, getCacheKey(path), [&path]()
 			{
+				core::trace::Scope scope("Load model", path);
 				tinyobj::attrib_t attrib;
 				std::vector<tinyobj::shape_t> shapes;
 				std::vector<tinyobj::material_t> materials;
@@ -31,7 +92,7 @@ namespace glue
 					throw std::runtime_error("Error: Model cannot loaded.");
 				}
 
-				auto& bvh = path_to_bvh[path] = std::make_shared<geometry::BVH<geometry::Triangle>>();
+				auto bvh = std::make_shared<geometry::BVH<geometry::Triangle>>();
 
 				int shapes_size = shapes.size();
 				if (shapes_size > 1)
@@ -70,30 +131,66 @@ namespace glue
 				}
 
 				bvh->buildWithSAHSplit();
-			}
 
-			return path_to_bvh[path];
+				std::size_t mapper_bytes = 0;
+				for (const auto& triangle : bvh->get_objects())
+				{
+					mapper_bytes += triangle.getMapperMemoryUsage();
+				}
+				auto name = getMemoryEntryName(path);
+				core::memory::set("BVH nodes", name, bvh->getNodeMemoryUsage());
+				core::memory::set("Triangles", name, bvh->getPrimitiveMemoryUsage());
+				core::memory::set("Mappers", name, mapper_bytes);
+
+				return bvh;
+			});
 		}
 
 		std::shared_ptr<std::vector<core::Image>> Parser::loadImage(const std::string& path, bool mipmapping)
 		{
-			static std::unordered_map<std::string, std::shared_ptr<std::vector<core::Image>>> path_to_image;
-
-			if (path_to_image.find(path) == path_to_image.end())
+			return loadCached(gPathToImage, gPathToImageMutex, getCacheKey(path), [&path, mipmapping]()
 			{
-				core::Image image(path);
+				auto image = [&path]()
+				{
+					core::trace::Scope scope("Decode image", path);
+					return core::Image(path);
+				}();
 
+				std::shared_ptr<std::vector<core::Image>> images;
 				if (mipmapping)
 				{
-					path_to_image[path] = std::make_shared<std::vector<core::Image>>(image.generateMipmaps());
+					core::trace::Scope scope("Generate mipmaps", path);
+					images = std::make_shared<std::vector<core::Image>>(image.generateMipmaps());
 				}
 				else
 				{
-					path_to_image[path] = std::make_shared<std::vector<core::Image>>(1, std::move(image));
+					images = std::make_shared<std::vector<core::Image>>(1, std::move(image));
 				}
-			}
 
-			return path_to_image[path];
+				std::size_t bytes = 0;
+				for (const auto& level : *images)
+				{
+					bytes += level.getMemoryUsage();
+				}
+				core::memory::set("Images", getMemoryEntryName(path) + (mipmapping ? " (mip chain)" : ""), bytes);
+
+				return images;
+			});
+		}
+
+		void Parser::setReplica(int replica)
+		{
+			tReplica = replica;
+		}
+
+		void Parser::clearCaches()
+		{
+			{
+				std::lock_guard<std::mutex> lock(gPathToBVHMutex);
+				gPathToBVH.clear();
+			}
+			std::lock_guard<std::mutex> lock(gPathToImageMutex);
+			gPathToImage.clear();
 		}
 	}
 }
\ No newline at end of file
@@ -22,6 +22,11 @@ namespace glue
 		public:
 			static std::shared_ptr<geometry::BVH<geometry::Triangle>> loadModel(const std::string& path);
 			static std::shared_ptr<std::vector<core::Image>> loadImage(const std::string& path, bool mipmapping = false);
+			//Models and images are cached per replica of the scene, so that every NUMA node can own a copy of them.
+			//It applies to the loads of the calling thread.
+			static void setReplica(int replica);
+			//Drops the cached models and images so that the next loads read the files again. Objects that hold them keep them alive.
+			static void clearCaches();
 		};
 	}
 }